@@ -1,113 +1,888 @@
 #include <iostream>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
 using namespace std;
 
-class Deque // circular buffer
+// elements per block: ~4KB worth, at least 16 so big T still gets real blocks
+template <typename T>
+constexpr size_t defaultBlockSize()
+{
+    return sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+}
+
+// ---------------------------------------------
+//  Deque<T>: circular buffer of blocks
+//      - elements live in fixed size blocks, the map is a circular buffer of
+//        block pointers. Growing only copies the map (pointers), never the
+//        elements, so references to elements stay valid across push/pop
+//      - blocks are kept when the deque shrinks and reused when it grows back
+// ---------------------------------------------
+template <typename T, size_t BlockSize = defaultBlockSize<T>()>
+class Deque
 {
 private:
-    int *arr;
-    int capacity_;
+    T **map;            // circular buffer of blocks, nullptr = not allocated yet
+    size_t mapCapacity; // power of two
+    size_t front;       // index of the first element in the whole ring (block * BlockSize + offset)
+    size_t count;
+    allocator<T> alloc;
+
+    size_t ringSize() const { return mapCapacity * BlockSize; }
 
-    int front;
-    int back;
-    int count;
+    // address of the element at ring index pos, allocating its block if needed
+    T *slot(size_t pos)
+    {
+        size_t block = pos / BlockSize;
+        if (map[block] == nullptr)
+            map[block] = alloc.allocate(BlockSize);
+        return map[block] + pos % BlockSize;
+    }
 
-    // expand
+    T &element(size_t i) const
+    {
+        size_t pos = (front + i) % ringSize();
+        return map[pos / BlockSize][pos % BlockSize];
+    }
 
+    // expand: double the map. Blocks keep their place relative to front, so
+    // only pointers are copied and elements never move.
     void expand()
     {
+        size_t newCapacity = mapCapacity == 0 ? 8 : mapCapacity * 2;
+        T **newMap = new T *[newCapacity]();
+
+        // front's block goes first, the rest follow in ring order (used or cached).
+        // push keeps a block of headroom, so the elements never wrap around into
+        // front's block and stay in order in the new map.
+        size_t firstBlock = mapCapacity == 0 ? 0 : front / BlockSize;
+        for (size_t i = 0; i < mapCapacity; i++)
+            newMap[i] = map[(firstBlock + i) & (mapCapacity - 1)];
+
+        delete[] map;
+        map = newMap;
+        front = front % BlockSize;
+        mapCapacity = newCapacity;
+    }
+
+    void freeBlocks()
+    {
+        clear();
+        for (size_t i = 0; i < mapCapacity; i++)
+        {
+            if (map[i] != nullptr)
+                alloc.deallocate(map[i], BlockSize);
+        }
+        delete[] map;
     }
 
 public:
-    Deque(int capacity_ = 10) : capacity_{capacity_}
+    // no blocks until the first push
+    Deque()
     {
-        arr = new int[capacity_];
-        count = 0;
+        map = nullptr;
+        mapCapacity = 0;
         front = 0;
-        back = 0;
+        count = 0;
+    }
+
+    // copy
+    Deque(const Deque &other) : Deque()
+    {
+        for (size_t i = 0; i < other.count; i++)
+            pushBack(other[i]);
+    }
+
+    Deque(Deque &&other) noexcept : map{other.map}, mapCapacity{other.mapCapacity}, front{other.front}, count{other.count}
+    {
+        other.map = nullptr;
+        other.mapCapacity = 0;
+        other.front = 0;
+        other.count = 0;
+    }
+
+    // copy operator
+    Deque &operator=(Deque other)
+    {
+        swap(map, other.map);
+        swap(mapCapacity, other.mapCapacity);
+        swap(front, other.front);
+        swap(count, other.count);
+        return *this;
+    }
+
+    // destructor
+    ~Deque()
+    {
+        freeBlocks();
+    }
+
+    // push (MOVING BACK)
+    template <typename... Args>
+    T &emplaceBack(Args &&...args)
+    {
+        // one block of headroom: the back block must never be front's block
+        if (count + BlockSize > ringSize())
+            expand();
+        T *p = slot((front + count) % ringSize());
+        new (p) T(std::forward<Args>(args)...);
+        count++;
+        return *p;
     }
-    // add (MOVING BACK)
-    void add(int num)
+    void pushBack(const T &value) { emplaceBack(value); }
+    void pushBack(T &&value) { emplaceBack(std::move(value)); }
+
+    // push (MOVING FRONT)
+    template <typename... Args>
+    T &emplaceFront(Args &&...args)
     {
-        if (isFull())
+        if (count + BlockSize > ringSize())
             expand();
-        arr[back] = num;
-        back = (back + 1) % capacity_;
-        count = count + 1;
+        size_t pos = (front + ringSize() - 1) % ringSize();
+        T *p = slot(pos);
+        new (p) T(std::forward<Args>(args)...);
+        front = pos;
+        count++;
+        return *p;
     }
+    void pushFront(const T &value) { emplaceFront(value); }
+    void pushFront(T &&value) { emplaceFront(std::move(value)); }
 
     // pop (MOVING FRONT)
-    int pop()
+    T popFront()
     {
         if (isEmpty())
-            return -1;
+            throw out_of_range("Deque::popFront on empty deque");
 
-        else
-        {
-            int o = arr[front];
-            front = (front + 1) % capacity_;
-            return o;
-        }
+        T &first = element(0);
+        T o = std::move(first);
+        first.~T();
+        front = (front + 1) % ringSize();
+        count--;
+        return o;
+    }
+
+    // pop (MOVING BACK)
+    T popBack()
+    {
+        if (isEmpty())
+            throw out_of_range("Deque::popBack on empty deque");
+
+        T &last = element(count - 1);
+        T o = std::move(last);
+        last.~T();
+        count--;
+        return o;
     }
+
+    T &operator[](size_t i) { return element(i); }
+    const T &operator[](size_t i) const { return element(i); }
+
+    T &peekFront() { return element(0); }
+    T &peekBack() { return element(count - 1); }
+
+    void clear()
+    {
+        for (size_t i = 0; i < count; i++)
+            element(i).~T();
+        count = 0;
+    }
+
     // size
-    int size() { return 1; }
+    size_t size() const { return count; }
     // isEmpty
-    bool isEmpty()
+    bool isEmpty() const
     {
         return (count == 0);
     }
-    // isFull
-    bool isFull()
+
+    // elements block by block, | between blocks
+    void print() const
     {
-        return (front == back && count != 0);
+        cout << "[";
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t pos = (front + i) % ringSize();
+            if (i != 0 && pos % BlockSize == 0)
+                cout << "| ";
+            cout << element(i) << " ";
+        }
+        cout << "] (" << count << " in " << mapCapacity << " blocks of " << BlockSize << ")\n";
     }
+};
+
+// rounds up to a power of two so ring indices can use a mask instead of %
+inline size_t ringCapacity(size_t capacity)
+{
+    size_t n = 2;
+    while (n < capacity)
+        n *= 2;
+    return n;
+}
 
-    void print()
+// ---------------------------------------------
+//  SPSCRing<T>: bounded lock-free ring for exactly one producer thread and
+//  one consumer thread. Both sides are wait-free.
+//      - head/tail are free running counters, slot = counter & mask
+//      - each side keeps a cached copy of the other side's index and only
+//        reloads it (a cache miss) when the ring looks full/empty
+// ---------------------------------------------
+template <typename T>
+class SPSCRing
+{
+private:
+    // consumer's cache line
+    alignas(64) atomic<size_t> head; // next slot to pop
+    size_t cachedTail;
+    // producer's cache line
+    alignas(64) atomic<size_t> tail; // next slot to push
+    size_t cachedHead;
+    // shared, read only
+    alignas(64) T *buffer;
+    size_t mask;
+    allocator<T> alloc;
+
+public:
+    SPSCRing(size_t capacity)
     {
-        cout << "[";
-        for (int i = 0; i < capacity_; i++)
+        mask = ringCapacity(capacity) - 1;
+        buffer = alloc.allocate(mask + 1);
+        head.store(0, memory_order_relaxed);
+        tail.store(0, memory_order_relaxed);
+        cachedHead = 0;
+        cachedTail = 0;
+    }
+
+    ~SPSCRing()
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        for (size_t h = head.load(memory_order_relaxed); h != t; h++)
+            buffer[h & mask].~T();
+        alloc.deallocate(buffer, mask + 1);
+    }
+
+    SPSCRing(const SPSCRing &) = delete;
+    SPSCRing &operator=(const SPSCRing &) = delete;
+
+    // producer only
+    template <typename U>
+    bool tryPush(U &&value)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cachedHead > mask)
+        {
+            cachedHead = head.load(memory_order_acquire);
+            if (t - cachedHead > mask)
+                return false; // full
+        }
+        new (&buffer[t & mask]) T(std::forward<U>(value));
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    // producer only: pushes as many of items[0..n) as fit with one release store,
+    // returns how many
+    size_t pushBatch(const T *items, size_t n)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+        size_t room = mask + 1 - (t - cachedHead);
+        if (room < n)
         {
-            cout << arr[i];
+            cachedHead = head.load(memory_order_acquire);
+            room = mask + 1 - (t - cachedHead);
+        }
+        n = min(n, room);
+        for (size_t i = 0; i < n; i++)
+            new (&buffer[(t + i) & mask]) T(items[i]);
+        tail.store(t + n, memory_order_release);
+        return n;
+    }
 
-            if (i == front)
+    // consumer only
+    bool tryPop(T &out)
+    {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cachedTail)
+        {
+            cachedTail = tail.load(memory_order_acquire);
+            if (h == cachedTail)
+                return false; // empty
+        }
+        T &slot = buffer[h & mask];
+        out = std::move(slot);
+        slot.~T();
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    // consumer only: pops up to max items into out, returns how many
+    size_t popBatch(T *out, size_t max)
+    {
+        size_t h = head.load(memory_order_relaxed);
+        if (cachedTail - h < max)
+            cachedTail = tail.load(memory_order_acquire);
+        size_t n = min(max, cachedTail - h);
+        for (size_t i = 0; i < n; i++)
+        {
+            T &slot = buffer[(h + i) & mask];
+            out[i] = std::move(slot);
+            slot.~T();
+        }
+        head.store(h + n, memory_order_release);
+        return n;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// ---------------------------------------------
+//  MPMCRing<T>: bounded lock-free ring for any number of producers and
+//  consumers (Dmitry Vyukov's design). Every cell has a sequence number that
+//  says whose turn it is:
+//      seq == pos           free, producer claiming pos may write
+//      seq == pos + 1       full, consumer claiming pos may read
+//      seq == pos + size    free again for the next lap
+//  A thread claims a position with one CAS on enqueuePos/dequeuePos; the
+//  batch calls claim a whole run of cells with that one CAS.
+// ---------------------------------------------
+template <typename T>
+class MPMCRing
+{
+private:
+    struct Cell
+    {
+        atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() { return reinterpret_cast<T *>(storage); }
+    };
+
+    alignas(64) Cell *buffer;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos;
+    alignas(64) atomic<size_t> dequeuePos;
+
+    // claims up to max consecutive cells at pos whose sequence is pos + i + offset.
+    // offset 0 = cells ready to write, 1 = cells ready to read
+    size_t claim(atomic<size_t> &position, size_t max, size_t offset, size_t &start)
+    {
+        size_t pos = position.load(memory_order_relaxed);
+        while (true)
+        {
+            size_t n = 0;
+            while (n < max)
             {
-                cout << "F";
+                size_t seq = buffer[(pos + n) & mask].sequence.load(memory_order_acquire);
+                if (seq != pos + n + offset)
+                    break;
+                n++;
             }
-            if (i == back)
+
+            if (n == 0)
             {
-                cout << "B";
+                // cell is a lap behind (full/empty), or another thread already took pos
+                size_t seq = buffer[pos & mask].sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)seq - (intptr_t)(pos + offset);
+                if (diff < 0)
+                    return 0;
+                pos = position.load(memory_order_relaxed);
+                continue;
             }
 
-            cout << " ";
+            if (position.compare_exchange_weak(pos, pos + n, memory_order_relaxed))
+            {
+                start = pos;
+                return n;
+            }
+            // pos was reloaded by the failed CAS, try again from there
         }
+    }
 
-        cout << "]\n";
+public:
+    MPMCRing(size_t capacity)
+    {
+        mask = ringCapacity(capacity) - 1;
+        buffer = new Cell[mask + 1];
+        for (size_t i = 0; i <= mask; i++)
+            buffer[i].sequence.store(i, memory_order_relaxed);
+        enqueuePos.store(0, memory_order_relaxed);
+        dequeuePos.store(0, memory_order_relaxed);
     }
 
-    // copy
-    // copy operator
-    // destructor
-    ~Deque()
+    // no other thread may still be using the ring
+    ~MPMCRing()
+    {
+        size_t end = enqueuePos.load(memory_order_relaxed);
+        for (size_t pos = dequeuePos.load(memory_order_relaxed); pos != end; pos++)
+            buffer[pos & mask].value()->~T();
+        delete[] buffer;
+    }
+
+    MPMCRing(const MPMCRing &) = delete;
+    MPMCRing &operator=(const MPMCRing &) = delete;
+
+    template <typename U>
+    bool tryPush(U &&value)
     {
+        size_t pos;
+        if (claim(enqueuePos, 1, 0, pos) == 0)
+            return false; // full
+        Cell &cell = buffer[pos & mask];
+        new (cell.value()) T(std::forward<U>(value));
+        cell.sequence.store(pos + 1, memory_order_release);
+        return true;
     }
+
+    // pushes as many of items[0..n) as fit, returns how many
+    size_t pushBatch(const T *items, size_t n)
+    {
+        size_t pos;
+        n = claim(enqueuePos, n, 0, pos);
+        for (size_t i = 0; i < n; i++)
+        {
+            Cell &cell = buffer[(pos + i) & mask];
+            new (cell.value()) T(items[i]);
+            cell.sequence.store(pos + i + 1, memory_order_release);
+        }
+        return n;
+    }
+
+    bool tryPop(T &out)
+    {
+        size_t pos;
+        if (claim(dequeuePos, 1, 1, pos) == 0)
+            return false; // empty
+        Cell &cell = buffer[pos & mask];
+        out = std::move(*cell.value());
+        cell.value()->~T();
+        cell.sequence.store(pos + mask + 1, memory_order_release);
+        return true;
+    }
+
+    // pops up to max items into out, returns how many
+    size_t popBatch(T *out, size_t max)
+    {
+        size_t pos;
+        size_t n = claim(dequeuePos, max, 1, pos);
+        for (size_t i = 0; i < n; i++)
+        {
+            Cell &cell = buffer[(pos + i) & mask];
+            out[i] = std::move(*cell.value());
+            cell.value()->~T();
+            cell.sequence.store(pos + i + mask + 1, memory_order_release);
+        }
+        return n;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// ---------------------------------------------
+//  WorkStealingDeque<T>: Chase-Lev deque (C11 version by Le et al.)
+//      - the owner thread pushes and pops at the bottom, like a stack
+//      - any other thread can steal from the top
+//      - the circular array doubles in expand() when full; the old array is kept
+//        until the deque dies, since a thief may still be reading from it
+//  T has to be trivially copyable (it is stored in atomics), tasks are pointers.
+// ---------------------------------------------
+template <typename T>
+class WorkStealingDeque
+{
+private:
+    struct Array
+    {
+        int64_t capacity; // power of two
+        atomic<T> *buffer;
+
+        Array(int64_t capacity) : capacity{capacity}, buffer{new atomic<T>[capacity]} {}
+        ~Array() { delete[] buffer; }
+
+        T get(int64_t i) { return buffer[i & (capacity - 1)].load(memory_order_relaxed); }
+        void put(int64_t i, T x) { buffer[i & (capacity - 1)].store(x, memory_order_relaxed); }
+    };
+
+    alignas(64) atomic<int64_t> top;    // thieves
+    alignas(64) atomic<int64_t> bottom; // owner
+    atomic<Array *> array;
+    vector<Array *> retired; // owner only
+
+    // expand: copy the live range [t, b) into an array twice the size
+    Array *expand(Array *a, int64_t b, int64_t t)
+    {
+        Array *bigger = new Array(a->capacity * 2);
+        for (int64_t i = t; i < b; i++)
+            bigger->put(i, a->get(i));
+        retired.push_back(a);
+        array.store(bigger, memory_order_release);
+        return bigger;
+    }
+
+public:
+    WorkStealingDeque(int64_t capacity = 64)
+    {
+        top.store(0, memory_order_relaxed);
+        bottom.store(0, memory_order_relaxed);
+        array.store(new Array(ringCapacity(capacity)), memory_order_relaxed);
+    }
+
+    ~WorkStealingDeque()
+    {
+        delete array.load(memory_order_relaxed);
+        for (auto *a : retired)
+            delete a;
+    }
+
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    // owner only
+    void push(T x)
+    {
+        int64_t b = bottom.load(memory_order_relaxed);
+        int64_t t = top.load(memory_order_acquire);
+        Array *a = array.load(memory_order_relaxed);
+        if (b - t > a->capacity - 1)
+            a = expand(a, b, t);
+        a->put(b, x);
+        atomic_thread_fence(memory_order_release);
+        bottom.store(b + 1, memory_order_relaxed);
+    }
+
+    // owner only, newest first
+    bool pop(T &out)
+    {
+        int64_t b = bottom.load(memory_order_relaxed) - 1;
+        Array *a = array.load(memory_order_relaxed);
+        bottom.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t t = top.load(memory_order_relaxed);
+
+        if (t > b)
+        {
+            // empty
+            bottom.store(b + 1, memory_order_relaxed);
+            return false;
+        }
+
+        out = a->get(b);
+        if (t == b)
+        {
+            // last element: race the thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+            bottom.store(b + 1, memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread, oldest first. false if empty or another thread got there first
+    bool steal(T &out)
+    {
+        int64_t t = top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t b = bottom.load(memory_order_acquire);
+        if (t >= b)
+            return false;
+
+        Array *a = array.load(memory_order_acquire);
+        T x = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            return false;
+        out = x;
+        return true;
+    }
+
+    // may be stale by the time it returns
+    bool isEmpty() const
+    {
+        return bottom.load(memory_order_relaxed) <= top.load(memory_order_relaxed);
+    }
+};
+
+// ---------------------------------------------
+//  ThreadPool: one WorkStealingDeque per worker, plus an MPMCRing for tasks
+//  submitted from outside the pool. A worker runs its own newest task first,
+//  then outside tasks, then steals the oldest task of a random other worker.
+//
+//  Fork/join goes through TaskGroup: run() forks, wait() joins and keeps
+//  running other tasks meanwhile, so nested waits never block a worker.
+// ---------------------------------------------
+class ThreadPool
+{
+public:
+    class TaskGroup;
+
+private:
+    struct Task
+    {
+        function<void()> fn;
+        TaskGroup *group;
+    };
+
+    struct alignas(64) Worker
+    {
+        WorkStealingDeque<Task *> tasks;
+        thread handle;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    MPMCRing<Task *> injected;
+    atomic<bool> stopping;
+
+    // which pool/worker the current thread is, -1 outside any pool
+    static thread_local ThreadPool *currentPool;
+    static thread_local int currentWorker;
+
+    void submit(Task *task)
+    {
+        if (currentPool == this)
+        {
+            workers[currentWorker]->tasks.push(task);
+            return;
+        }
+        while (!injected.tryPush(task))
+            this_thread::yield();
+    }
+
+    // run one task from anywhere, false if there was nothing to do
+    bool runOne(uint64_t &seed)
+    {
+        Task *task = nullptr;
+        bool found = false;
+        if (currentPool == this)
+            found = workers[currentWorker]->tasks.pop(task);
+        if (!found)
+            found = injected.tryPop(task);
+        for (size_t i = 0; !found && i < workers.size(); i++)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; // LCG, cheap victim pick
+            size_t victim = (seed >> 33) % workers.size();
+            if ((int)victim != currentWorker || currentPool != this)
+                found = workers[victim]->tasks.steal(task);
+        }
+        if (!found)
+            return false;
+
+        task->fn();
+        task->group->pending.fetch_sub(1, memory_order_release);
+        delete task;
+        return true;
+    }
+
+    void workerLoop(int index)
+    {
+        currentPool = this;
+        currentWorker = index;
+        uint64_t seed = index + 1;
+        int idle = 0;
+        while (!stopping.load(memory_order_relaxed))
+        {
+            if (runOne(seed))
+                idle = 0;
+            else if (++idle < 64)
+                this_thread::yield();
+            else
+                this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+
+public:
+    class TaskGroup
+    {
+    private:
+        friend class ThreadPool;
+        ThreadPool &pool;
+        atomic<int64_t> pending;
+
+    public:
+        TaskGroup(ThreadPool &pool) : pool{pool} { pending.store(0, memory_order_relaxed); }
+        ~TaskGroup() { wait(); }
+
+        // fork
+        void run(function<void()> fn)
+        {
+            pending.fetch_add(1, memory_order_relaxed);
+            pool.submit(new Task{std::move(fn), this});
+        }
+
+        // join, helping with other tasks until every run() here has finished
+        void wait()
+        {
+            uint64_t seed = reinterpret_cast<uintptr_t>(this);
+            while (pending.load(memory_order_acquire) > 0)
+            {
+                if (!pool.runOne(seed))
+                    this_thread::yield();
+            }
+        }
+    };
+
+    ThreadPool(size_t threads = 0) : injected(1024)
+    {
+        if (threads == 0)
+            threads = max(1u, thread::hardware_concurrency());
+        stopping.store(false, memory_order_relaxed);
+        for (size_t i = 0; i < threads; i++)
+            workers.push_back(make_unique<Worker>());
+        for (size_t i = 0; i < threads; i++)
+            workers[i]->handle = thread(&ThreadPool::workerLoop, this, (int)i);
+    }
+
+    // every TaskGroup must have been waited on
+    ~ThreadPool()
+    {
+        stopping.store(true, memory_order_relaxed);
+        for (auto &w : workers)
+            w->handle.join();
+    }
+
+    size_t size() const { return workers.size(); }
 };
 
+thread_local ThreadPool *ThreadPool::currentPool = nullptr;
+thread_local int ThreadPool::currentWorker = -1;
+
+// ----------------------------
+// fork/join benchmark: naive fib, forking until n gets small
+// ----------------------------
+uint64_t fibSerial(int n)
+{
+    return n < 2 ? n : fibSerial(n - 1) + fibSerial(n - 2);
+}
+
+uint64_t fibParallel(ThreadPool &pool, int n)
+{
+    if (n < 25)
+        return fibSerial(n);
+    uint64_t a, b;
+    ThreadPool::TaskGroup group(pool);
+    group.run([&]
+              { a = fibParallel(pool, n - 1); });
+    b = fibParallel(pool, n - 2);
+    group.wait();
+    return a + b;
+}
+
+// ----------------------------
+// ring demo: producers push 0..n-1 in batches, consumers add up what they pop
+// ----------------------------
+template <typename Ring>
+void ringDemo(const char *name, int producers, int consumers, size_t n)
+{
+    Ring ring(1024);
+    atomic<size_t> popped{0};
+    atomic<uint64_t> sum{0};
+    const size_t BATCH = 32;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&, p]
+                             {
+            size_t items[BATCH];
+            for (size_t i = p; i < n;)
+            {
+                size_t k = 0;
+                for (size_t j = i; j < n && k < BATCH; j += producers)
+                    items[k++] = j;
+                size_t sent = 0;
+                while (sent < k)
+                {
+                    size_t pushed = ring.pushBatch(items + sent, k - sent);
+                    if (pushed == 0)
+                        this_thread::yield();
+                    sent += pushed;
+                }
+                i += k * producers;
+            } });
+    }
+    for (int c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&]
+                             {
+            size_t items[BATCH];
+            uint64_t local = 0;
+            while (popped.load(memory_order_relaxed) < n)
+            {
+                size_t got = ring.popBatch(items, BATCH);
+                if (got == 0)
+                {
+                    this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < got; i++)
+                    local += items[i];
+                popped.fetch_add(got, memory_order_relaxed);
+            }
+            sum.fetch_add(local); });
+    }
+    for (auto &t : threads)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool ok = sum.load() == (uint64_t)n * (n - 1) / 2;
+    cout << name << " " << producers << "P/" << consumers << "C: " << n / seconds / 1e6 << " Mops/s "
+         << (ok ? "(sum ok)" : "(SUM WRONG)") << endl;
+}
+
 int main()
 {
-    cout << "-- DEQUE -- \n;";
-    Deque que(5);
-    que.add(2);
+    cout << "-- DEQUE -- \n";
+    Deque<int, 4> que; // small blocks so the growth shows up
+    que.pushBack(2);
     que.print();
-    que.add(3);
-    que.add(4);
+    que.pushBack(3);
+    que.pushBack(4);
     que.print();
-    que.add(3);
-    que.add(4);
+    que.pushFront(1);
+    que.pushFront(0);
     que.print();
-    cout << que.pop() << endl;
-    cout << que.pop() << endl;
-    cout << que.pop() << endl;
-    cout << que.pop() << endl;
+
+    int &stable = que[2];
+    for (int i = 5; i < 40; i++)
+        que.pushBack(i);
     que.print();
-    cout << que.pop() << endl;
+    cout << "still " << stable << " after growing" << endl;
+
+    cout << que.popFront() << endl;
+    cout << que.popFront() << endl;
+    cout << que.popBack() << endl;
+    cout << que.popBack() << endl;
     que.print();
+
+    Deque<string> words;
+    words.pushBack("world");
+    words.pushFront("hello");
+    Deque<string> copy = words;
+    Deque<string> moved = std::move(words);
+    copy.print();
+    moved.print();
+
+    cout << "-- RING BUFFERS -- \n";
+    ringDemo<SPSCRing<size_t>>("SPSCRing", 1, 1, 5000000);
+    ringDemo<MPMCRing<size_t>>("MPMCRing", 2, 2, 5000000);
+
+    cout << "-- WORK STEALING -- (fib(36), " << thread::hardware_concurrency() << " hardware threads)\n";
+    unsigned maxThreads = max(4u, thread::hardware_concurrency());
+    double oneThread = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        auto start = chrono::steady_clock::now();
+        uint64_t result = fibParallel(pool, 36);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1)
+            oneThread = seconds;
+        cout << threads << " threads: " << result << " in " << seconds * 1000 << " ms, speedup "
+             << oneThread / seconds << "x" << endl;
+    }
 }
@@ -1,107 +1,975 @@
-#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <algorithm>
+#include <chrono>
 using namespace std;
 
-class LRUNode{
+constexpr uint32_t NIL = UINT32_MAX;
+
+// murmur3 finalizer: std::hash is the identity for ints, mix it so neither
+// the probe sequence nor the shard choice clusters
+inline uint64_t mixHash(uint64_t h){
+    h ^= (h >> 33);
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= (h >> 33);
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= (h >> 33);
+    return h;
+}
+
+// ---------------------------------------------
+//  NodeLists: intrusive doubly linked lists over slab indices [0, n).
+//      a node is in at most one list, list l's sentinel is index n + l.
+//      Eviction policies keep their recency lists in here.
+// ---------------------------------------------
+class NodeLists {
 private:
+    vector<uint32_t> next;
+    vector<uint32_t> prev;
+    vector<size_t> sizes;
+    uint32_t nodeCount;
+
 public:
-    int val;
-    LRUNode* next;
-    LRUNode* prev;
-    int key;
-    LRUNode(int key, int val){
-        this->val = val;
-        this->key = key;
+    NodeLists(uint32_t nodes, uint32_t lists) {
+        nodeCount = nodes;
+        next.assign(nodes + lists, NIL);
+        prev.assign(nodes + lists, NIL);
+        sizes.assign(lists, 0);
+        for(uint32_t l = 0; l < lists; l++){
+            next[nodes + l] = nodes + l;
+            prev[nodes + l] = nodes + l;
+        }
+    }
+
+    void pushFront(uint32_t l, uint32_t n){
+        uint32_t head = nodeCount + l;
+        uint32_t temp = next[head];
+        next[n] = temp;
+        prev[n] = head;
+
+        next[head] = n;
+        prev[temp] = n;
+        sizes[l]++;
+    }
+
+    void remove(uint32_t l, uint32_t n){
+        next[prev[n]] = next[n];
+        prev[next[n]] = prev[n];
+        sizes[l]--;
+    }
+
+    void moveToFront(uint32_t from, uint32_t to, uint32_t n){
+        remove(from, n);
+        pushFront(to, n);
+    }
+
+    // least recent node of list l, NIL if empty
+    uint32_t back(uint32_t l) const {
+        uint32_t last = prev[nodeCount + l];
+        return last == nodeCount + l ? NIL : last;
+    }
+
+    size_t size(uint32_t l) const { return sizes[l]; }
+
+    // the node in front of n (towards the list's head), NIL past the head
+    uint32_t prevOf(uint32_t n) const {
+        return prev[n] >= nodeCount ? NIL : prev[n];
     }
 };
 
+// ---------------------------------------------
+//  Eviction policies, plugged into LRUCache as a template parameter.
+//  They only see slab indices (and the key hash), never keys or values:
+//      onHit(n)            n was read or overwritten
+//      onMiss(hash)        key with this hash wasn't cached
+//      onInsert(n, hash)   n was just added
+//      victim()            cache is over capacity: pick a node, forget it, return it
+//      onRemove(n)         n was erased
+// ---------------------------------------------
+
+// plain LRU: one list, evict the tail (what LRUCache always did)
+class LRUPolicy {
+private:
+    NodeLists lists;
+public:
+    LRUPolicy(size_t capacity, uint32_t slabSize) : lists(slabSize, 1) { (void)capacity; }
+
+    void onHit(uint32_t n){ lists.moveToFront(0, 0, n); }
+    void onMiss(uint64_t){}
+    void onInsert(uint32_t n, uint64_t){ lists.pushFront(0, n); }
+
+    uint32_t victim(){
+        uint32_t last = lists.back(0);
+        lists.remove(0, last);
+        return last;
+    }
+
+    void onRemove(uint32_t n){ lists.remove(0, n); }
+};
+
+// ---------------------------------------------
+//  Segmented LRU: new keys go to probation, a second hit promotes to protected.
+//  A scan only ever churns probation, the protected segment survives it.
+// ---------------------------------------------
+class SLRUPolicy {
+private:
+    static constexpr uint32_t PROBATION = 0;
+    static constexpr uint32_t PROTECTED = 1;
+
+    NodeLists lists;
+    vector<uint8_t> segment;
+    size_t protectedMax;
+
+public:
+    SLRUPolicy(size_t capacity, uint32_t slabSize) : lists(slabSize, 2), segment(slabSize, PROBATION) {
+        protectedMax = capacity * 8 / 10; // 80% protected
+    }
+
+    void onHit(uint32_t n){
+        if(segment[n] == PROTECTED){
+            lists.moveToFront(PROTECTED, PROTECTED, n);
+            return;
+        }
+        lists.moveToFront(PROBATION, PROTECTED, n);
+        segment[n] = PROTECTED;
+
+        // protected is full: its least recent node gets another chance in probation
+        if(lists.size(PROTECTED) > protectedMax){
+            uint32_t demoted = lists.back(PROTECTED);
+            lists.moveToFront(PROTECTED, PROBATION, demoted);
+            segment[demoted] = PROBATION;
+        }
+    }
+
+    void onMiss(uint64_t){}
+
+    void onInsert(uint32_t n, uint64_t){
+        lists.pushFront(PROBATION, n);
+        segment[n] = PROBATION;
+    }
+
+    uint32_t victim(){
+        uint32_t l = lists.size(PROBATION) > 0 ? PROBATION : PROTECTED;
+        uint32_t last = lists.back(l);
+        lists.remove(l, last);
+        return last;
+    }
+
+    void onRemove(uint32_t n){ lists.remove(segment[n], n); }
+};
+
+// ---------------------------------------------
+//  FrequencySketch: count-min sketch with 4 bit counters (16 per uint64_t),
+//  4 rows. Every counter is halved after 10 * width increments so old
+//  popularity fades out.
+// ---------------------------------------------
+class FrequencySketch {
+private:
+    static constexpr int DEPTH = 4;
+    static constexpr uint64_t SEEDS[DEPTH] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+    vector<uint64_t> table; // DEPTH rows of width / 16 words
+    size_t width;           // counters per row, power of two
+    size_t additions;
+    size_t sampleSize;
+
+    // word and shift of the counter for row r
+    void locate(uint64_t hash, int r, size_t& word, int& shift) const {
+        size_t i = mixHash(hash + SEEDS[r]) & (width - 1);
+        word = r * (width / 16) + (i >> 4);
+        shift = (i & 15) * 4;
+    }
+
+    void reset(){
+        for(auto& w : table) w = (w >> 1) & 0x7777777777777777ULL;
+        additions /= 2;
+    }
+
+public:
+    FrequencySketch(size_t capacity) {
+        width = 16;
+        while(width < capacity) width *= 2;
+        table.assign(DEPTH * (width / 16), 0);
+        additions = 0;
+        sampleSize = 10 * width;
+    }
+
+    void increment(uint64_t hash){
+        bool added = false;
+        for(int r = 0; r < DEPTH; r++){
+            size_t word;
+            int shift;
+            locate(hash, r, word, shift);
+            if(((table[word] >> shift) & 0xF) < 15){
+                table[word] += 1ULL << shift;
+                added = true;
+            }
+        }
+        if(added && ++additions == sampleSize) reset();
+    }
+
+    int frequency(uint64_t hash) const {
+        int f = 15;
+        for(int r = 0; r < DEPTH; r++){
+            size_t word;
+            int shift;
+            locate(hash, r, word, shift);
+            f = min(f, (int)((table[word] >> shift) & 0xF));
+        }
+        return f;
+    }
+};
+
+// ---------------------------------------------
+//  W-TinyLFU: a small LRU window (1%) in front of an SLRU main space.
+//  When the window overflows, its victim only gets into main if the sketch
+//  says it's more popular than main's victim, so one-off keys from a scan
+//  can't push out the hot set.
+// ---------------------------------------------
+class WTinyLFUPolicy {
+private:
+    static constexpr uint32_t WINDOW = 0;
+    static constexpr uint32_t PROBATION = 1;
+    static constexpr uint32_t PROTECTED = 2;
+
+    NodeLists lists;
+    vector<uint8_t> segment;
+    vector<uint64_t> hashes;
+    FrequencySketch sketch;
+    size_t capacity;
+    size_t count;
+    size_t windowMax;
+    size_t protectedMax;
+
+    void move(uint32_t n, uint32_t to){
+        lists.moveToFront(segment[n], to, n);
+        segment[n] = to;
+    }
+
+public:
+    WTinyLFUPolicy(size_t capacity, uint32_t slabSize)
+        : lists(slabSize, 3), segment(slabSize, WINDOW), hashes(slabSize, 0), sketch(capacity) {
+        this->capacity = capacity;
+        count = 0;
+        windowMax = max<size_t>(1, capacity / 100);
+        protectedMax = (capacity - min(capacity, windowMax)) * 8 / 10;
+    }
+
+    void onHit(uint32_t n){
+        sketch.increment(hashes[n]);
+        if(segment[n] != PROBATION){
+            move(n, segment[n]); // window and protected are plain LRU
+            return;
+        }
+        move(n, PROTECTED);
+        if(lists.size(PROTECTED) > protectedMax) move(lists.back(PROTECTED), PROBATION);
+    }
+
+    void onMiss(uint64_t hash){ sketch.increment(hash); }
+
+    void onInsert(uint32_t n, uint64_t hash){
+        hashes[n] = hash;
+        segment[n] = WINDOW;
+        lists.pushFront(WINDOW, n);
+        count++;
+
+        // still room: window overflow moves to main for free
+        if(count <= capacity){
+            while(lists.size(WINDOW) > windowMax) move(lists.back(WINDOW), PROBATION);
+        }
+    }
+
+    uint32_t victim(){
+        count--;
+
+        uint32_t candidate = lists.size(WINDOW) > windowMax ? lists.back(WINDOW) : NIL;
+        uint32_t mainVictim = lists.back(PROBATION);
+        if(mainVictim == NIL) mainVictim = lists.back(PROTECTED);
+
+        uint32_t evict;
+        if(candidate == NIL) evict = mainVictim != NIL ? mainVictim : lists.back(WINDOW);
+        else if(mainVictim == NIL) evict = candidate;
+        else if(sketch.frequency(hashes[candidate]) > sketch.frequency(hashes[mainVictim])){
+            move(candidate, PROBATION); // admitted
+            evict = mainVictim;
+        }
+        else evict = candidate;
+
+        lists.remove(segment[evict], evict);
+        return evict;
+    }
+
+    void onRemove(uint32_t n){
+        lists.remove(segment[n], n);
+        count--;
+    }
+};
+
+// ---------------------------------------------
+//  LatencyHistogram: log2 buckets of nanoseconds, bucket i holds [2^i, 2^(i+1))
+// ---------------------------------------------
+class LatencyHistogram {
+private:
+    static constexpr int BUCKETS = 48;
+    uint64_t buckets[BUCKETS] = {};
+    uint64_t total = 0;
+
+public:
+    void record(uint64_t ns){
+        int b = 0;
+        while(ns > 1 && b < BUCKETS - 1){
+            ns >>= 1;
+            b++;
+        }
+        buckets[b]++;
+        total++;
+    }
+
+    void merge(const LatencyHistogram& o){
+        for(int i = 0; i < BUCKETS; i++) buckets[i] += o.buckets[i];
+        total += o.total;
+    }
+
+    uint64_t count() const { return total; }
+
+    // upper bound (ns) of the bucket holding the p-th percentile, p in [0, 100]
+    uint64_t percentile(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * total);
+        uint64_t seen = 0;
+        for(int i = 0; i < BUCKETS; i++){
+            seen += buckets[i];
+            if(seen > rank) return 2ULL << i;
+        }
+        return 2ULL << (BUCKETS - 1);
+    }
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;   // pushed out by capacity or weight
+    uint64_t expirations = 0; // TTL ran out
+    LatencyHistogram getLatency; // only filled with CacheOptions::recordLatency
+    LatencyHistogram putLatency;
+
+    double hitRate() const {
+        uint64_t lookups = hits + misses;
+        return lookups == 0 ? 0.0 : (double)hits / lookups;
+    }
+
+    void merge(const CacheStats& o){
+        hits += o.hits;
+        misses += o.misses;
+        evictions += o.evictions;
+        expirations += o.expirations;
+        getLatency.merge(o.getLatency);
+        putLatency.merge(o.putLatency);
+    }
+};
+
+template <typename K, typename V>
+struct CacheOptions {
+    size_t maxWeight = 0;                           // 0 = only bounded by entry count
+    size_t maxEntryWeight = 0;                      // heavier entries aren't cached, 0 = maxWeight
+    function<size_t(const K&, const V&)> weigher;   // weight of one entry, 1 if not set
+    chrono::nanoseconds expireAfterWrite{0};        // default TTL for put(), 0 = never
+    chrono::nanoseconds tick = chrono::seconds(1);  // timer wheel resolution
+    bool recordLatency = false;                     // get/put latency histograms
+};
+
+// ---------------------------------------------
+//  LRUNode: lives in the cache's slab, the policy keeps the ordering
+// ---------------------------------------------
+template <typename K, typename V>
+class LRUNode{
+public:
+    K key;
+    V val;
+    uint32_t slot;     // where the node sits in the index table
+    uint32_t nextFree; // free list link
+    size_t weight;
+    int64_t expiresAt; // steady clock ns, 0 = never
+    uint32_t bucket;   // timer wheel bucket, NIL if not on the wheel
+};
+
+// ---------------------------------------------
+//  LRUCache<K, V, Hash, Policy>
+//      - nodes are preallocated once (capacity + 1 spare) and recycled
+//        through a free list, so get/put never allocate
+//      - key => node index is a flat open addressing table (linear probing,
+//        backward shift delete), one probe per get/put
+//      - what to evict is up to Policy (LRU by default, see above)
+//      - optional weight limit and per entry TTL, see CacheOptions. Expired
+//        entries are never returned, a hashed timer wheel reclaims them
+//        without scanning the whole cache
+// ---------------------------------------------
+template <typename K, typename V, typename Hash = std::hash<K>, typename Policy = LRUPolicy>
 class LRUCache {
 private:
-    unordered_map<int, LRUNode*> cache;
-    int capacity;
-    LRUNode* head;
-    LRUNode* tail;
+    static constexpr uint32_t WHEEL_SIZE = 256; // power of two
+
+    struct Slot {
+        uint32_t node;     // NIL if empty
+        uint32_t hashBits; // low bits of the hash, so probing rarely compares keys
+    };
+
+    vector<LRUNode<K, V>> nodes;
+    vector<Slot> table;
+    size_t mask;
+    size_t capacity;
+    size_t count;
+    size_t totalWeight;
+    uint32_t freeHead;
+    Hash hasher;
+    Policy policy;
+    CacheOptions<K, V> options;
+    CacheStats counters;
+
+    NodeLists wheel;     // one list per bucket
+    int64_t tickNs;
+    int64_t wheelTick;   // last tick the wheel was advanced to
+    size_t onWheel;      // nodes with a TTL
+
+    static size_t checkCapacity(size_t capacity){
+        if(capacity > UINT32_MAX / 4) throw invalid_argument("LRUCache: capacity too large");
+        return capacity;
+    }
+
+    static int64_t nowNs(){
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
 
-    void addToCache(LRUNode* newNode){
-        LRUNode* temp = head->next;
-        newNode->next = temp;
-        newNode->prev = head;
-        
-        head->next = newNode;
-        temp->prev = newNode;
+    uint64_t hashOf(const K& key) const {
+        return mixHash(hasher(key));
     }
 
-    void moveToHead(LRUNode* newNode){
-        removeNode(newNode);
-        addToCache(newNode);
+    // slot holding key, or the empty slot it would go in
+    size_t findSlot(const K& key, uint64_t h) const {
+        uint32_t bits = static_cast<uint32_t>(h);
+        size_t i = bits & mask;
+        while(table[i].node != NIL){
+            if(table[i].hashBits == bits && nodes[table[i].node].key == key) return i;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // backward shift delete: pull later entries of the probe run into the hole
+    void eraseSlot(size_t hole){
+        size_t j = hole;
+        while(true){
+            j = (j + 1) & mask;
+            if(table[j].node == NIL) break;
+
+            size_t home = table[j].hashBits & mask;
+            // entry can only move back if its home isn't in (hole, j]
+            bool stays = (hole < j) ? (home > hole && home <= j) : (home > hole || home <= j);
+            if(stays) continue;
+
+            table[hole] = table[j];
+            nodes[table[hole].node].slot = hole;
+            hole = j;
+        }
+        table[hole].node = NIL;
+    }
+
+    bool expired(uint32_t n, int64_t now) const {
+        return nodes[n].expiresAt != 0 && nodes[n].expiresAt <= now;
     }
 
-    void removeNode(LRUNode* t){
-        t->next->prev = t->prev;
-        t->prev->next = t->next;
+    void setExpiry(uint32_t n, chrono::nanoseconds ttl, int64_t now){
+        if(nodes[n].bucket != NIL){
+            wheel.remove(nodes[n].bucket, n);
+            nodes[n].bucket = NIL;
+            onWheel--;
+        }
+        if(ttl.count() <= 0){
+            nodes[n].expiresAt = 0;
+            return;
+        }
+        if(onWheel == 0) wheelTick = now / tickNs; // wheel was idle, don't replay old ticks
+
+        nodes[n].expiresAt = now + ttl.count();
+        // bucket of the first tick that starts at or after expiresAt, so the entry
+        // is due by the time its bucket is visited. Entries more than a lap away
+        // are revisited every lap until due.
+        nodes[n].bucket = ((nodes[n].expiresAt + tickNs - 1) / tickNs) & (WHEEL_SIZE - 1);
+        wheel.pushFront(nodes[n].bucket, n);
+        onWheel++;
+    }
+
+    // unhook n from the table, the wheel and the weight total, back to the free list.
+    // The policy has already forgotten n.
+    void release(uint32_t n){
+        eraseSlot(nodes[n].slot);
+        if(nodes[n].bucket != NIL){
+            wheel.remove(nodes[n].bucket, n);
+            nodes[n].bucket = NIL;
+            onWheel--;
+        }
+        // free what the key and value hold now, not when the node gets reused.
+        // Moved out rather than assigned over, a string keeps its buffer on assignment.
+        {
+            K oldKey = std::move(nodes[n].key);
+            V oldVal = std::move(nodes[n].val);
+            (void)oldKey;
+            (void)oldVal;
+        }
+        totalWeight -= nodes[n].weight;
+        nodes[n].nextFree = freeHead;
+        freeHead = n;
+        count--;
+    }
+
+    void expire(uint32_t n){
+        policy.onRemove(n);
+        release(n);
+        counters.expirations++;
+    }
+
+    // visit the buckets of every tick that has passed since the last call
+    void advanceWheel(int64_t now){
+        if(onWheel == 0) return;
+        int64_t target = now / tickNs;
+        int64_t steps = min<int64_t>(target - wheelTick, WHEEL_SIZE); // a full lap covers every bucket
+        for(int64_t t = 0; t < steps; t++){
+            uint32_t b = (wheelTick + 1 + t) & (WHEEL_SIZE - 1);
+            uint32_t n = wheel.back(b);
+            while(n != NIL){
+                uint32_t next = wheel.prevOf(n);
+                if(expired(n, now)) expire(n);
+                n = next;
+            }
+        }
+        wheelTick = target;
+    }
+
+    bool overLimit() const {
+        if(count > capacity) return true;
+        // one entry on its own may go over maxWeight, up to maxEntryWeight
+        return options.maxWeight > 0 && totalWeight > options.maxWeight && count > 1;
+    }
+
+    size_t entryLimit() const {
+        return options.maxEntryWeight > 0 ? options.maxEntryWeight : options.maxWeight;
+    }
+
+    void evictOverLimit(){
+        while(count > 0 && overLimit()){
+            release(policy.victim());
+            counters.evictions++;
+        }
+    }
+
+    size_t weigh(const K& key, const V& value) const {
+        return options.weigher ? options.weigher(key, value) : 1;
     }
 
 public:
-    LRUCache(int capacity) {
+    // a new entry is added before the victim is evicted (so the key's probe slot
+    // stays valid), hence the 1 spare node
+    LRUCache(size_t capacity, CacheOptions<K, V> options = {})
+        : policy(checkCapacity(capacity), capacity + 1), wheel(capacity + 1, WHEEL_SIZE) {
         this->capacity = capacity;
-        head = new LRUNode(-1, 0);
-        tail = new LRUNode(-1, 0);
-        head->next = tail;
-        tail->prev = head;
-    }
-    
-    int get(int key) {
-        //check for key not found
-            //return -1
-        // check if key exist
-            // move to most recent
-            // return value
-
-        // if cache finds a key
-        if(cache.find(key) != cache.end()){
-            LRUNode* node = cache[key];
-            moveToHead(node);
-            return node->val;
-        }
-        return -1;
-    }
-    
-    void put(int key, int value) {
-        //check key if found:
-            // update value
-            // return
-        //check for capacity
-            //if full, 'update' tail node
-            //update head.next node to new node
-            //point head => new node
-            // return
-        // finally, update exisitng value
-        
+        this->options = std::move(options);
+        count = 0;
+        totalWeight = 0;
+
+        tickNs = max<int64_t>(1, this->options.tick.count());
+        wheelTick = 0;
+        onWheel = 0;
+
+        nodes.resize(capacity + 1);
+        freeHead = NIL;
+        for(uint32_t i = nodes.size(); i > 0; i--){
+            nodes[i - 1].nextFree = freeHead;
+            nodes[i - 1].slot = 0;
+            nodes[i - 1].bucket = NIL;
+            freeHead = i - 1;
+        }
+
+        // keep the table at most half full
+        size_t tableSize = 8;
+        while(tableSize < (capacity + 1) * 2) tableSize *= 2;
+        table.assign(tableSize, Slot{NIL, 0});
+        mask = tableSize - 1;
+    }
+
+    // pointer to the value (nullptr if not cached or expired), counts as a use of key
+    V* get(const K& key) {
+        int64_t start = options.recordLatency ? nowNs() : 0;
+        int64_t now = onWheel > 0 ? nowNs() : 0;
+        advanceWheel(now);
+
+        uint64_t h = hashOf(key);
+        size_t i = findSlot(key, h);
+        uint32_t n = table[i].node;
+
+        if(n != NIL && expired(n, now)){
+            expire(n);
+            n = NIL;
+        }
+
+        V* result = nullptr;
+        if(n == NIL){
+            policy.onMiss(h);
+            counters.misses++;
+        }
+        else{
+            policy.onHit(n);
+            counters.hits++;
+            result = &nodes[n].val;
+        }
+
+        if(options.recordLatency) counters.getLatency.record(nowNs() - start);
+        return result;
+    }
+
+    // ttl overrides CacheOptions::expireAfterWrite, 0 = never expires
+    void put(K key, V value, chrono::nanoseconds ttl) {
+        if(capacity == 0) return;
+        int64_t start = options.recordLatency ? nowNs() : 0;
+        int64_t now = (onWheel > 0 || ttl.count() > 0) ? nowNs() : 0;
+        advanceWheel(now);
+
+        uint64_t h = hashOf(key);
+        size_t i = findSlot(key, h);
+        size_t w = weigh(key, value);
+
+        // would push out everything else and still not fit: drop it (and the old value)
+        if(entryLimit() > 0 && w > entryLimit()){
+            if(table[i].node != NIL){
+                policy.onRemove(table[i].node);
+                release(table[i].node);
+            }
+            counters.evictions++;
+        }
         // if in cache, update
-        if(cache.find(key) != cache.end()){
-            LRUNode* temp = cache[key];
-            temp->val = value;
-            moveToHead(temp); //move updated node to front
-            return;
+        else if(table[i].node != NIL){
+            uint32_t n = table[i].node;
+            totalWeight += w - nodes[n].weight;
+            nodes[n].weight = w;
+            nodes[n].val = std::move(value);
+            setExpiry(n, ttl, now);
+            policy.onHit(n);
+        }
+        else{
+            // take a recycled node and hand it to the policy
+            policy.onMiss(h);
+            uint32_t n = freeHead;
+            freeHead = nodes[n].nextFree;
+            nodes[n].key = std::move(key);
+            nodes[n].val = std::move(value);
+            nodes[n].slot = i;
+            nodes[n].weight = w;
+            table[i] = Slot{n, static_cast<uint32_t>(h)};
+            setExpiry(n, ttl, now);
+            policy.onInsert(n, h);
+            count++;
+            totalWeight += w;
         }
 
-        // if cache is full
-        if(cache.size() == capacity){
-            LRUNode* last = tail->prev;
-            cache.erase(last->key);
+        // if cache is over capacity (or weight), the policy's victims go back to the free list
+        evictOverLimit();
+
+        if(options.recordLatency) counters.putLatency.record(nowNs() - start);
+    }
+
+    void put(K key, V value) {
+        put(std::move(key), std::move(value), options.expireAfterWrite);
+    }
+
+    size_t size() const { return count; }
+    size_t weight() const { return totalWeight; }
+    const CacheStats& stats() const { return counters; }
+
+    // expire whatever is due now, without waiting for the next get/put
+    void cleanUp(){
+        advanceWheel(nowNs());
+    }
+
+    // ----------------------------
+    // split get() for ConcurrentLRUCache: find/valueOf under a shared lock,
+    // touch later under the exclusive one
+    // ----------------------------
+
+    // node index for key without changing the order or the stats, NIL if not
+    // cached or expired
+    uint32_t find(const K& key) const {
+        size_t i = findSlot(key, hashOf(key));
+        uint32_t n = table[i].node;
+        if(n != NIL && nodes[n].expiresAt != 0 && expired(n, nowNs())) return NIL;
+        return n;
+    }
+
+    const V& valueOf(uint32_t n) const { return nodes[n].val; }
+
+    // counts as a hit on node n. n may be stale (evicted or reused since find()),
+    // a free node is skipped and a reused one just gets the hit
+    void touch(uint32_t n){
+        if(n >= nodes.size()) return;
+        if(table[nodes[n].slot].node != n) return; // on the free list
+        policy.onHit(n);
+    }
+
+    // erase key, true if it was cached. Used for the ARC ghost lists.
+    bool erase(const K& key){
+        size_t i = findSlot(key, hashOf(key));
+        uint32_t n = table[i].node;
+        if(n == NIL) return false;
+
+        policy.onRemove(n);
+        release(n);
+        return true;
+    }
+};
+
+// ---------------------------------------------
+//  ARC (adaptive replacement cache): T1 holds keys seen once, T2 keys seen
+//  twice or more. B1/B2 remember the hashes of what was recently evicted from
+//  each; a hit in a ghost list shifts the target size p of T1 towards
+//  whichever side would have kept it.
+// ---------------------------------------------
+class ARCPolicy {
+private:
+    static constexpr uint32_t T1 = 0;
+    static constexpr uint32_t T2 = 1;
+
+    NodeLists lists;
+    vector<uint8_t> segment;
+    vector<uint64_t> hashes;
+    LRUCache<uint64_t, bool> ghost1; // B1
+    LRUCache<uint64_t, bool> ghost2; // B2
+    size_t capacity;
+    size_t p; // target size of T1
+    uint32_t lastInserted;
+    bool lastFromGhost2;
+
+    uint32_t evictFrom(uint32_t l){
+        uint32_t n = lists.back(l);
+        lists.remove(l, n);
+        (l == T1 ? ghost1 : ghost2).put(hashes[n], true);
+        if(n == lastInserted) lastInserted = NIL;
+        return n;
+    }
+
+    // lastInserted only matters for the evictions right after its insert, any
+    // other call means put() is done with it
+    void forgetInsert(){
+        lastInserted = NIL;
+        lastFromGhost2 = false;
+    }
+
+public:
+    ARCPolicy(size_t capacity, uint32_t slabSize)
+        : lists(slabSize, 2), segment(slabSize, T1), hashes(slabSize, 0), ghost1(capacity), ghost2(capacity) {
+        this->capacity = capacity;
+        p = 0;
+        lastInserted = NIL;
+        lastFromGhost2 = false;
+    }
+
+    void onHit(uint32_t n){
+        forgetInsert();
+        lists.moveToFront(segment[n], T2, n);
+        segment[n] = T2;
+    }
+
+    void onMiss(uint64_t){ forgetInsert(); }
+
+    void onInsert(uint32_t n, uint64_t hash){
+        hashes[n] = hash;
+        lastInserted = n;
+        lastFromGhost2 = false;
+
+        size_t b1 = ghost1.size(), b2 = ghost2.size();
+        if(ghost1.erase(hash)){ // recency side was too small
+            p = min(capacity, p + max<size_t>(1, b2 / b1));
+            segment[n] = T2;
+        }
+        else if(ghost2.erase(hash)){ // frequency side was too small
+            p -= min(p, max<size_t>(1, b1 / b2));
+            segment[n] = T2;
+            lastFromGhost2 = true;
+        }
+        else segment[n] = T1;
+        lists.pushFront(segment[n], n);
+    }
+
+    // ARC's REPLACE, a node put() just inserted doesn't count towards |T1|.
+    // Also called when an update made an entry heavier, then nothing is new.
+    uint32_t victim(){
+        bool fresh = lastInserted != NIL;
+        size_t t1 = lists.size(T1) - (fresh && segment[lastInserted] == T1 ? 1 : 0);
+        bool fromT1 = t1 > 0 && (t1 > p || (lastFromGhost2 && t1 == p));
+
+        uint32_t l = fromT1 ? T1 : T2;
+        uint32_t other = (l == T1 ? T2 : T1);
+        // never an empty list, and the new node only if there's nothing else
+        if(lists.size(l) == 0 || (fresh && lists.back(l) == lastInserted && lists.size(other) > 0)) l = other;
+        return evictFrom(l);
+    }
+
+    void onRemove(uint32_t n){
+        forgetInsert();
+        lists.remove(segment[n], n);
+    }
+};
+
+// ---------------------------------------------
+//  ConcurrentLRUCache<K, V, Hash, Policy>
+//      - keys hash to one of N shards, each an LRUCache with its own lock
+//      - get() only takes the shard's shared lock: the hit is written to a small
+//        read buffer and the LRU list is updated later, in a batch, by whoever
+//        holds the exclusive lock (put, or a reader that finds the buffer full)
+//      - while the buffer is full and nobody got the lock yet, promotions are
+//        dropped, so very hot keys cost a read lock + one fetch_add instead of
+//        a list update each time
+// ---------------------------------------------
+template <typename K, typename V, typename Hash = std::hash<K>, typename Policy = LRUPolicy>
+class ConcurrentLRUCache {
+private:
+    static constexpr size_t READ_BUFFER_SIZE = 64;
+
+    struct alignas(64) Shard {
+        shared_mutex lock;
+        LRUCache<K, V, Hash, Policy> cache;
+        atomic<size_t> reads; // read buffer slots handed out since the last drain
+        atomic<uint32_t> readBuffer[READ_BUFFER_SIZE];
+        atomic<uint64_t> hits;   // get() doesn't go through cache.get, so it
+        atomic<uint64_t> misses; // keeps its own counts
+
+        Shard(size_t capacity, const CacheOptions<K, V>& options) : cache(capacity, options) {
+            reads.store(0, memory_order_relaxed);
+            hits.store(0, memory_order_relaxed);
+            misses.store(0, memory_order_relaxed);
+            for(auto& r : readBuffer) r.store(NIL, memory_order_relaxed);
+        }
+    };
+
+    vector<unique_ptr<Shard>> shards;
+    size_t shardMask;
+    Hash hasher;
+
+    Shard& shardFor(const K& key){
+        // LRUCache probes with the low bits, pick the shard with the high ones
+        return *shards[(mixHash(hasher(key)) >> 40) & shardMask];
+    }
+
+    // exclusive lock must be held
+    void drainReads(Shard& s){
+        size_t n = min(s.reads.load(memory_order_relaxed), READ_BUFFER_SIZE);
+        for(size_t i = 0; i < n; i++){
+            s.cache.touch(s.readBuffer[i].load(memory_order_relaxed));
+            s.readBuffer[i].store(NIL, memory_order_relaxed);
+        }
+        s.reads.store(0, memory_order_relaxed);
+    }
+
+public:
+    // shardCount is rounded up to a power of two (0 = 4 per hardware thread),
+    // then halved while there would be more shards than entries.
+    // capacity and options.maxWeight are split between the shards, so the
+    // totals are exactly what was asked for. A shard can still take one entry
+    // heavier than its share (up to maxEntryWeight, by default the whole
+    // maxWeight): it evicts everything else for it, and the total weight may go
+    // over maxWeight by that much.
+    ConcurrentLRUCache(size_t capacity, size_t shardCount = 0, CacheOptions<K, V> options = {}) {
+        if(shardCount == 0) shardCount = max(1u, thread::hardware_concurrency()) * 4;
+        size_t n = 1;
+        while(n < shardCount) n *= 2;
+        while(n > 1 && n > capacity) n /= 2;
+        shardMask = n - 1;
+
+        size_t maxWeight = options.maxWeight;
+        if(options.maxEntryWeight == 0) options.maxEntryWeight = maxWeight;
+        for(size_t i = 0; i < n; i++){
+            size_t perShard = capacity / n + (i < capacity % n ? 1 : 0);
+            if(maxWeight > 0) options.maxWeight = max<size_t>(1, maxWeight / n + (i < maxWeight % n ? 1 : 0));
+            shards.push_back(make_unique<Shard>(perShard, options));
+        }
+    }
+
+    // copy of the value, nullopt if not cached or expired
+    optional<V> get(const K& key) {
+        Shard& s = shardFor(key);
+        optional<V> result;
+        size_t ticket;
+        {
+            shared_lock<shared_mutex> read(s.lock);
+            uint32_t n = s.cache.find(key);
+            if(n == NIL){
+                s.misses.fetch_add(1, memory_order_relaxed);
+                return result;
+            }
+            result = s.cache.valueOf(n);
+            s.hits.fetch_add(1, memory_order_relaxed);
+
+            // record the hit, or drop it if the buffer is already full
+            ticket = s.reads.fetch_add(1, memory_order_relaxed);
+            if(ticket < READ_BUFFER_SIZE) s.readBuffer[ticket].store(n, memory_order_relaxed);
+        }
+
+        // any reader that finds the buffer full tries to apply it, but never waits
+        // for the lock. Only one attempt would mostly fail while other readers
+        // hold the shared lock, and then every later hit would be dropped.
+        if(ticket + 1 >= READ_BUFFER_SIZE){
+            unique_lock<shared_mutex> write(s.lock, try_to_lock);
+            if(write.owns_lock()) drainReads(s);
+        }
+        return result;
+    }
+
+    void put(K key, V value) {
+        Shard& s = shardFor(key);
+        unique_lock<shared_mutex> write(s.lock);
+        drainReads(s); // keep recency right before something gets evicted
+        s.cache.put(std::move(key), std::move(value));
+    }
+
+    void put(K key, V value, chrono::nanoseconds ttl) {
+        Shard& s = shardFor(key);
+        unique_lock<shared_mutex> write(s.lock);
+        drainReads(s);
+        s.cache.put(std::move(key), std::move(value), ttl);
+    }
+
+    // sum over the shards. Latency histograms only cover put(), get() never
+    // reaches LRUCache::get.
+    CacheStats stats() {
+        CacheStats total;
+        for(auto& s : shards){
+            shared_lock<shared_mutex> read(s->lock);
+            total.merge(s->cache.stats());
+            total.hits += s->hits.load(memory_order_relaxed);
+            total.misses += s->misses.load(memory_order_relaxed);
+        }
+        return total;
+    }
 
-            //remove last from the list
-            removeNode(tail->prev);
+    size_t size() {
+        size_t total = 0;
+        for(auto& s : shards){
+            shared_lock<shared_mutex> read(s->lock);
+            total += s->cache.size();
         }
-        // add node to front
-        LRUNode* newNode = new LRUNode(key, value);
-        addToCache(newNode);
-        cache[key] = newNode;
+        return total;
     }
 };
 
 /**
  * Your LRUCache object will be instantiated and called as such:
- * LRUCache* obj = new LRUCache(capacity);
- * int param_1 = obj->get(key);
+ * LRUCache<int, int>* obj = new LRUCache<int, int>(capacity);
+ * int* param_1 = obj->get(key); // nullptr if key isn't cached
  * obj->put(key,value);
  */
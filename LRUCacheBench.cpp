@@ -0,0 +1,205 @@
+/*
+    Benchmark for LRUCache.cpp
+        - trace replay: hit ratio and ops/s of every eviction policy. The default
+          trace is zipf traffic with a scan of cold keys every so often, or pass a
+          file with one integer key per line
+        - weights, TTL and erase: random operations on every policy, checks the
+          entry and weight limits hold
+        - thread scaling: ConcurrentLRUCache vs one LRUCache behind a single mutex,
+          90% get / 10% put on zipf distributed keys
+
+    build: g++ -std=c++17 -O2 -pthread LRUCacheBench.cpp -o lruBench
+    run:   ./lruBench [maxThreads] [traceFile]
+*/
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+#include "LRUCache.cpp"
+
+using Clock = chrono::steady_clock;
+
+// ----------------------------
+// zipf(s) keys over [0, n): a few keys are hot, most are cold
+// ----------------------------
+vector<int> makeZipfKeys(size_t count, size_t n, double s, uint32_t seed){
+    vector<double> cdf(n);
+    double sum = 0;
+    for(size_t i = 0; i < n; i++){
+        sum += 1.0 / pow(i + 1, s);
+        cdf[i] = sum;
+    }
+
+    mt19937 rng(seed);
+    uniform_real_distribution<double> dist(0, sum);
+    vector<int> keys(count);
+    for(auto& k : keys) k = lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+    return keys;
+}
+
+// hot zipf traffic, interrupted by scans over keys that are never seen again
+vector<int> makeScanTrace(size_t capacity){
+    vector<int> hot = makeZipfKeys(4000000, capacity * 10, 0.9, 11);
+    vector<int> trace;
+    int coldKey = 1 << 30;
+    for(size_t i = 0; i < hot.size(); i++){
+        trace.push_back(hot[i]);
+        if(i % 500000 == 499999){
+            for(size_t j = 0; j < capacity * 2; j++) trace.push_back(coldKey++);
+        }
+    }
+    return trace;
+}
+
+vector<int> readTrace(const string& path){
+    ifstream file(path);
+    if(!file.is_open()){
+        cerr << "Error: can't open trace " << path << endl;
+        exit(1);
+    }
+    vector<int> trace;
+    int key;
+    while(file >> key) trace.push_back(key);
+    return trace;
+}
+
+// get, and put on a miss, like a read-through cache would
+template <typename Policy>
+void replay(const char* name, const vector<int>& trace, size_t capacity){
+    LRUCache<int, int, std::hash<int>, Policy> cache(capacity);
+    size_t hits = 0;
+
+    auto start = Clock::now();
+    for(int key : trace){
+        if(cache.get(key) != nullptr) hits++;
+        else cache.put(key, key);
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    cout << name << "\t" << fixed << setprecision(2) << 100.0 * hits / trace.size() << " %\t\t"
+         << trace.size() / seconds / 1e6 << "\n";
+    cout << defaultfloat << setprecision(6);
+}
+
+// random puts (weight = value), TTLs, gets and erases. Checks the limits hold
+// and that a hit always returns the last value put for that key.
+template <typename Policy>
+bool checkWeighted(const char* name){
+    CacheOptions<int, int> options;
+    options.maxWeight = 100;
+    options.weigher = [](const int&, const int& v){ return (size_t)v; };
+    options.tick = chrono::microseconds(100);
+    LRUCache<int, int, std::hash<int>, Policy> cache(20, options);
+
+    // an update that only makes an entry heavier still has to evict
+    cache.put(1, 2);
+    cache.put(2, 2);
+    cache.get(2);
+    cache.get(1);
+    cache.put(1, 99);
+
+    mt19937 rng(5);
+    unordered_map<int, int> last;
+    bool ok = cache.weight() <= options.maxWeight;
+    for(int i = 0; i < 200000 && ok; i++){
+        int key = rng() % 50;
+        switch(rng() % 4){
+            case 0:
+            case 1: {
+                int value = 1 + rng() % 40;
+                if(rng() % 8 == 0) cache.put(key, value, chrono::microseconds(rng() % 500));
+                else cache.put(key, value);
+                last[key] = value;
+                break;
+            }
+            case 2: {
+                int* v = cache.get(key);
+                ok = v == nullptr || *v == last[key];
+                break;
+            }
+            case 3: cache.erase(key); break;
+        }
+        ok = ok && cache.size() <= 20 && cache.weight() <= options.maxWeight;
+    }
+    cout << name << "\t" << (ok ? "ok" : "FAILED") << "\n";
+    return ok;
+}
+
+// single mutex around the plain cache, the thing we're trying to beat
+class LockedLRUCache {
+private:
+    mutex lock;
+    LRUCache<int, int> cache;
+public:
+    LockedLRUCache(size_t capacity) : cache(capacity) {}
+    optional<int> get(int key){
+        lock_guard<mutex> guard(lock);
+        int* v = cache.get(key);
+        if(v == nullptr) return nullopt;
+        return *v;
+    }
+    void put(int key, int value){
+        lock_guard<mutex> guard(lock);
+        cache.put(key, value);
+    }
+};
+
+// every thread runs opsPerThread operations, returns total Mops/s
+template <typename Cache>
+double runThreads(Cache& cache, int threads, const vector<int>& keys, size_t opsPerThread){
+    vector<thread> workers;
+    auto start = Clock::now();
+    for(int t = 0; t < threads; t++){
+        workers.emplace_back([&, t]{
+            size_t offset = (keys.size() / threads) * t;
+            for(size_t i = 0; i < opsPerThread; i++){
+                int key = keys[(offset + i) % keys.size()];
+                if(i % 10 == 0) cache.put(key, key);
+                else cache.get(key);
+            }
+        });
+    }
+    for(auto& w : workers) w.join();
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    return threads * opsPerThread / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]){
+    int maxThreads = argc > 1 ? stoi(argv[1]) : max(1u, thread::hardware_concurrency());
+    const size_t capacity = 100000;
+    const size_t opsPerThread = 2000000;
+    vector<int> keys = makeZipfKeys(1 << 20, capacity * 10, 0.99, 7);
+
+    const size_t traceCapacity = 10000;
+    vector<int> trace = argc > 2 ? readTrace(argv[2]) : makeScanTrace(traceCapacity);
+    cout << "-- TRACE REPLAY -- (" << trace.size() << " accesses, capacity " << traceCapacity << ")\n";
+    cout << "policy\thit ratio\tMops/s\n";
+    replay<LRUPolicy>("LRU", trace, traceCapacity);
+    replay<SLRUPolicy>("SLRU", trace, traceCapacity);
+    replay<ARCPolicy>("ARC", trace, traceCapacity);
+    replay<WTinyLFUPolicy>("W-TinyLFU", trace, traceCapacity);
+    cout << "\n";
+
+    cout << "-- WEIGHTS, TTL AND ERASE --\n";
+    bool ok = checkWeighted<LRUPolicy>("LRU");
+    ok = checkWeighted<SLRUPolicy>("SLRU") && ok;
+    ok = checkWeighted<ARCPolicy>("ARC") && ok;
+    ok = checkWeighted<WTinyLFUPolicy>("W-TinyLFU") && ok;
+    if(!ok) return 1;
+    cout << "\n";
+
+    cout << "-- THREAD SCALING -- (" << thread::hardware_concurrency() << " hardware threads)\n";
+    cout << "threads\tsharded Mops/s\tsingle mutex Mops/s\n";
+    for(int threads = 1; threads <= maxThreads; threads *= 2){
+        ConcurrentLRUCache<int, int> sharded(capacity);
+        LockedLRUCache locked(capacity);
+        double a = runThreads(sharded, threads, keys, opsPerThread);
+        double b = runThreads(locked, threads, keys, opsPerThread);
+        cout << threads << "\t" << a << "\t\t" << b << "\n";
+    }
+}
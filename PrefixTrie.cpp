@@ -1,5 +1,12 @@
 #include <cctype>
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <algorithm>
+using namespace std;
 
 class TreeNode {
 public:
@@ -22,6 +29,41 @@ private:
         return tolower(a) - 'a';
     }
 
+    // one trie level of the edit-distance table: rows[depth] is the
+    // Levenshtein row for the prefix that ends at node (row by row DP)
+    void fuzzyWalk(TreeNode* node, char letter, const string& word, int maxEdits, int depth,
+                   vector<int>& rows, string& prefix, vector<string>& results){
+        int columns = word.size() + 1;
+        if((int)rows.size() < (depth + 1) * columns) rows.resize((depth + 1) * columns);
+
+        int prev = (depth - 1) * columns; // row of the parent
+        int cur = depth * columns;
+
+        rows[cur] = rows[prev] + 1;
+        int rowMin = rows[cur];
+        for(int j = 1; j < columns; j++){
+            int insertCost = rows[cur + j - 1] + 1;
+            int deleteCost = rows[prev + j] + 1;
+            int replaceCost = rows[prev + j - 1] + (word[j - 1] != letter ? 1 : 0);
+            rows[cur + j] = min(insertCost, min(deleteCost, replaceCost));
+            rowMin = min(rowMin, rows[cur + j]);
+        }
+
+        if(node->validWordEnd && rows[cur + columns - 1] <= maxEdits){
+            results.push_back(prefix);
+        }
+
+        // every cell is already over budget, nothing below this node can match
+        if(rowMin > maxEdits) return;
+
+        for(int i = 0; i < 26; i++){
+            if(node->children[i] == nullptr) continue;
+            prefix.push_back('a' + i);
+            fuzzyWalk(node->children[i], 'a' + i, word, maxEdits, depth + 1, rows, prefix, results);
+            prefix.pop_back();
+        }
+    }
+
 
 public:
     TreeNode* root;
@@ -75,4 +117,323 @@ public:
         // if we're here, the for-loop finished without returning false
         return true; // since words can be BOTH prefixes and valid word ends.
     }
+
+    // every word within maxEdits insertions/deletions/replacements of word
+    vector<string> fuzzy_search(string word, int maxEdits) {
+        vector<string> results;
+        if(maxEdits < 0) return results;
+
+        for(char& c : word) c = tolower(c); // tree only stores lowercase
+
+        // row 0 is the distance from the empty prefix: j deletions
+        int columns = word.size() + 1;
+        vector<int> rows(columns * 8);
+        for(int j = 0; j < columns; j++) rows[j] = j;
+
+        if(root->validWordEnd && (int)word.size() <= maxEdits) results.push_back("");
+
+        string prefix;
+        for(int i = 0; i < 26; i++){
+            if(root->children[i] == nullptr) continue;
+            prefix.push_back('a' + i);
+            fuzzyWalk(root->children[i], 'a' + i, word, maxEdits, 1, rows, prefix, results);
+            prefix.pop_back();
+        }
+        return results;
+    }
+};
+
+// ---------------------------------------------
+//  ConcurrentPrefixTree
+//      readers (search/startsWith) never lock: children are atomic pointers
+//      writers lock one node at a time going down (lock coupling)
+//      removed nodes are freed through epoch based reclamation
+// ---------------------------------------------
+class ConcurrentTreeNode {
+public:
+    atomic<ConcurrentTreeNode*> children[26];
+    atomic<bool> validWordEnd;
+    mutex lock; // only writers touch this
+
+    ConcurrentTreeNode(){
+        validWordEnd.store(false, memory_order_relaxed);
+        for (int i = 0; i < 26; i++) {
+            children[i].store(nullptr, memory_order_relaxed);
+        }
+    }
+
+    int childCount(){
+        int n = 0;
+        for (int i = 0; i < 26; i++) {
+            if(children[i].load(memory_order_relaxed) != nullptr) n++;
+        }
+        return n;
+    }
+};
+
+// ---------------------------------------------
+//  EpochManager: readers publish the epoch they entered in, a retired node
+//  is only deleted once every active reader has moved past the epoch it was
+//  unlinked in. One manager is shared by every ConcurrentPrefixTree.
+// ---------------------------------------------
+class EpochManager {
+private:
+    static const int MAX_THREADS = 128;
+    static const uint64_t INACTIVE = UINT64_MAX;
+    static const size_t COLLECT_EVERY = 64; // retired nodes between collect() calls
+
+    struct alignas(64) Slot { // padded so readers don't share cache lines
+        atomic<uint64_t> epoch{INACTIVE};
+        atomic<bool> owned{false};
+    };
+
+    struct Retired {
+        ConcurrentTreeNode* node;
+        uint64_t epoch;
+    };
+
+    // releases the thread's slot when the thread exits
+    struct SlotHandle {
+        EpochManager* owner = nullptr;
+        int index = -1;
+        ~SlotHandle(){
+            if(owner != nullptr) owner->slots[index].owned.store(false, memory_order_release);
+        }
+    };
+
+    atomic<uint64_t> globalEpoch{0};
+    Slot slots[MAX_THREADS];
+    mutex retiredLock;
+    vector<Retired> retired;
+
+    int claimSlot(){
+        thread_local SlotHandle handle;
+        if(handle.owner == this) return handle.index;
+
+        for(int i = 0; i < MAX_THREADS; i++){
+            bool expected = false;
+            if(slots[i].owned.compare_exchange_strong(expected, true, memory_order_acq_rel)){
+                handle.owner = this;
+                handle.index = i;
+                return i;
+            }
+        }
+        throw runtime_error("EpochManager: too many reader threads");
+    }
+
+    EpochManager() = default;
+
+public:
+    static EpochManager& instance(){
+        static EpochManager manager;
+        return manager;
+    }
+
+    ~EpochManager(){
+        for(auto& r : retired) delete r.node;
+    }
+
+    // enter/leave a read side critical section (no nesting)
+    int enter(){
+        int i = claimSlot();
+        slots[i].epoch.store(globalEpoch.load(memory_order_seq_cst), memory_order_relaxed);
+        // pairs with the fence in collect(): either collect() sees this slot,
+        // or this reader sees every unlink that happened before collect()
+        atomic_thread_fence(memory_order_seq_cst);
+        return i;
+    }
+    void leave(int i){
+        slots[i].epoch.store(INACTIVE, memory_order_release);
+    }
+
+    // node must already be unlinked from its tree
+    void retire(ConcurrentTreeNode* node){
+        uint64_t e = globalEpoch.fetch_add(1, memory_order_seq_cst);
+        bool doCollect;
+        {
+            lock_guard<mutex> guard(retiredLock);
+            retired.push_back({node, e});
+            doCollect = retired.size() % COLLECT_EVERY == 0;
+        }
+        if(doCollect) collect();
+    }
+
+    // free every retired node no active reader can still be looking at.
+    // Only nodes retired before the slot scan are considered: one retired while
+    // we scan may be held by a reader that entered after we looked at its slot.
+    void collect(){
+        uint64_t scanEpoch = globalEpoch.load(memory_order_seq_cst);
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t freeBelow = scanEpoch; // min(scanEpoch, oldest active reader)
+        for(int i = 0; i < MAX_THREADS; i++){
+            uint64_t e = slots[i].epoch.load(memory_order_acquire);
+            if(e < freeBelow) freeBelow = e;
+        }
+
+        vector<ConcurrentTreeNode*> toFree;
+        {
+            lock_guard<mutex> guard(retiredLock);
+            size_t kept = 0;
+            for(size_t i = 0; i < retired.size(); i++){
+                if(retired[i].epoch < freeBelow) toFree.push_back(retired[i].node);
+                else retired[kept++] = retired[i];
+            }
+            retired.resize(kept);
+        }
+        for(auto* node : toFree) delete node;
+    }
+};
+
+// RAII read guard
+class EpochGuard {
+private:
+    int slot;
+public:
+    EpochGuard(){ slot = EpochManager::instance().enter(); }
+    ~EpochGuard(){ EpochManager::instance().leave(slot); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+class ConcurrentPrefixTree {
+
+private:
+    ConcurrentTreeNode* root;
+
+    // for CHAR to INT translation, -1 for anything that isn't a letter
+    static int charToInt(char a){
+        unsigned char c = static_cast<unsigned char>(a);
+        if(!isalpha(c)) return -1;
+        return tolower(c) - 'a';
+    }
+
+    // lock-free walk down to the node for prefix (nullptr if missing)
+    ConcurrentTreeNode* find(const string& prefix){
+        ConcurrentTreeNode* temp = root;
+
+        for(size_t i = 0; i < prefix.size(); i++){
+            int cIndex = charToInt(prefix[i]);
+            if(cIndex < 0) return nullptr;
+
+            temp = temp->children[cIndex].load(memory_order_acquire);
+            if(temp == nullptr) return nullptr;
+        }
+        return temp;
+    }
+
+    static void destroy(ConcurrentTreeNode* node){
+        for(int i = 0; i < 26; i++){
+            ConcurrentTreeNode* child = node->children[i].load(memory_order_relaxed);
+            if(child != nullptr) destroy(child);
+        }
+        delete node;
+    }
+
+public:
+    ConcurrentPrefixTree() {
+        root = new ConcurrentTreeNode();
+    }
+
+    // not thread safe, every other thread must be done with the tree
+    ~ConcurrentPrefixTree() {
+        destroy(root);
+    }
+
+    ConcurrentPrefixTree(const ConcurrentPrefixTree&) = delete;
+    ConcurrentPrefixTree& operator=(const ConcurrentPrefixTree&) = delete;
+
+    // returns false if word has a non-letter in it
+    bool insert(const string& word) {
+        for(char c : word){
+            if(charToInt(c) < 0) return false;
+        }
+
+        // lock coupling: hold the parent until the child is locked, so a
+        // remove() can't unlink the child from under us
+        ConcurrentTreeNode* temp = root;
+        temp->lock.lock();
+
+        for(size_t i = 0; i < word.size(); i++){
+            int cIndex = charToInt(word[i]);
+
+            ConcurrentTreeNode* child = temp->children[cIndex].load(memory_order_relaxed);
+            if(child == nullptr){
+                child = new ConcurrentTreeNode();
+                temp->children[cIndex].store(child, memory_order_release); // publish to readers
+            }
+            child->lock.lock();
+            temp->lock.unlock();
+            temp = child;
+        }
+
+        temp->validWordEnd.store(true, memory_order_release);
+        temp->lock.unlock();
+        return true;
+    }
+
+    // unmarks word and prunes the branch that is left without any words
+    bool remove(const string& word) {
+        for(char c : word){
+            if(charToInt(c) < 0) return false;
+        }
+
+        // path[first..] are locked. Once a node on the way down still has to exist
+        // after the remove (it ends another word or has other children) nothing above
+        // it can be pruned, so the locks above it are let go.
+        vector<ConcurrentTreeNode*> path;
+        path.reserve(word.size() + 1);
+        size_t first = 0;
+
+        root->lock.lock();
+        path.push_back(root);
+
+        for(size_t i = 0; i < word.size(); i++){
+            ConcurrentTreeNode* child = path.back()->children[charToInt(word[i])].load(memory_order_relaxed);
+            if(child == nullptr){
+                for(size_t j = first; j < path.size(); j++) path[j]->lock.unlock();
+                return false;
+            }
+            child->lock.lock();
+            path.push_back(child);
+
+            bool last = (i + 1 == word.size());
+            if((!last && child->validWordEnd.load(memory_order_relaxed)) || child->childCount() > 1){
+                for(size_t j = first; j < path.size() - 1; j++) path[j]->lock.unlock();
+                first = path.size() - 1;
+            }
+        }
+
+        ConcurrentTreeNode* end = path.back();
+        bool found = end->validWordEnd.load(memory_order_relaxed);
+
+        vector<ConcurrentTreeNode*> pruned;
+        if(found){
+            end->validWordEnd.store(false, memory_order_release);
+
+            // walk back up, unlinking nodes that no longer lead to a word
+            for(size_t i = path.size() - 1; i > first; i--){
+                ConcurrentTreeNode* node = path[i];
+                if(node->validWordEnd.load(memory_order_relaxed) || node->childCount() > 0) break;
+                path[i - 1]->children[charToInt(word[i - 1])].store(nullptr, memory_order_release);
+                pruned.push_back(node);
+            }
+        }
+
+        for(size_t j = path.size(); j > first; j--) path[j - 1]->lock.unlock();
+
+        // readers may still be standing on pruned nodes, let the epochs decide
+        for(auto* node : pruned) EpochManager::instance().retire(node);
+        return found;
+    }
+
+    bool search(const string& word) {
+        EpochGuard guard;
+        ConcurrentTreeNode* temp = find(word);
+        return temp != nullptr && temp->validWordEnd.load(memory_order_acquire);
+    }
+
+    bool startsWith(const string& prefix) {
+        EpochGuard guard;
+        return find(prefix) != nullptr;
+    }
 };
@@ -0,0 +1,275 @@
+/*
+    Benchmark for PrefixTree::fuzzy_search
+        - builds a dictionary of N generated words (default 1,000,000)
+        - times fuzzy_search at k=1 and k=2 against a brute force scan of the word list
+        - checks both return the same number of matches
+    and a stress test for ConcurrentPrefixTree
+        - writer threads insert/remove their own words while reader threads search
+        - checks readers never lose a word nobody touches or find one nobody
+          inserted, that the tree matches what each writer did at the end, and
+          that removing the rest prunes every branch left without words
+        - removers empty the tree together, round after round, while readers
+          walk it: nodes must not be freed while a reader can still reach them
+
+    build: g++ -std=c++17 -O2 -pthread PrefixTrieBench.cpp -o prefixBench
+    run:   ./prefixBench [numWords] [numQueries] [threads]
+*/
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <unordered_set>
+#include <thread>
+#include "PrefixTrie.cpp"
+
+using Clock = chrono::steady_clock;
+
+// ----------------------------
+// word generator: glue together consonant+vowel syllables so the words
+// share prefixes the way a real dictionary does (random letters wouldn't)
+// ----------------------------
+vector<string> makeDictionary(size_t n, mt19937& rng){
+    const string consonants = "bcdfghjklmnprstvwz";
+    const string vowels = "aeiou";
+    uniform_int_distribution<int> syllables(1, 5);
+
+    unordered_set<string> seen;
+    vector<string> words;
+    words.reserve(n);
+    while(words.size() < n){
+        string w;
+        int count = syllables(rng);
+        for(int i = 0; i < count; i++){
+            w += consonants[rng() % consonants.size()];
+            w += vowels[rng() % vowels.size()];
+            if(rng() % 4 == 0) w += consonants[rng() % consonants.size()];
+        }
+        if(seen.insert(w).second) words.push_back(w);
+    }
+    return words;
+}
+
+// ----------------------------
+// brute force: full Levenshtein against every word, stop a row early once it's over k
+// ----------------------------
+bool withinDistance(const string& a, const string& b, int k){
+    if(abs((int)a.size() - (int)b.size()) > k) return false;
+
+    vector<int> prev(b.size() + 1), cur(b.size() + 1);
+    for(size_t j = 0; j <= b.size(); j++) prev[j] = j;
+
+    for(size_t i = 1; i <= a.size(); i++){
+        cur[0] = i;
+        int rowMin = cur[0];
+        for(size_t j = 1; j <= b.size(); j++){
+            cur[j] = min({cur[j - 1] + 1, prev[j] + 1, prev[j - 1] + (a[i - 1] != b[j - 1] ? 1 : 0)});
+            rowMin = min(rowMin, cur[j]);
+        }
+        if(rowMin > k) return false;
+        swap(prev, cur);
+    }
+    return prev[b.size()] <= k;
+}
+
+size_t bruteForce(const vector<string>& words, const string& query, int k){
+    size_t found = 0;
+    for(const auto& w : words){
+        if(withinDistance(query, w, k)) found++;
+    }
+    return found;
+}
+
+// typo a dictionary word so queries look like what a user would type
+string makeQuery(const vector<string>& words, mt19937& rng){
+    string q = words[rng() % words.size()];
+    size_t pos = rng() % q.size();
+    switch(rng() % 3){
+        case 0: q[pos] = 'a' + rng() % 26; break;   // replace
+        case 1: q.insert(q.begin() + pos, 'a' + rng() % 26); break; // insert
+        case 2: if(q.size() > 1) q.erase(q.begin() + pos); break;   // delete
+    }
+    return q;
+}
+
+// ----------------------------
+// ConcurrentPrefixTree stress: the words are split into
+//      stable  inserted up front, never removed, must always be found
+//      absent  never inserted, must never be found
+//      churn   split between the writers, each inserts/removes only its own
+// so the expected final state is known without locking anything.
+// Words share prefixes, so removes prune branches right next to live words.
+// ----------------------------
+bool stressConcurrent(const vector<string>& words, int writers, int readers, size_t opsPerWriter){
+    ConcurrentPrefixTree tree;
+    size_t quarter = words.size() / 4;
+    vector<string> stable(words.begin(), words.begin() + quarter);
+    vector<string> absent(words.begin() + quarter, words.begin() + 2 * quarter);
+    vector<string> churn(words.begin() + 2 * quarter, words.end());
+    for(const auto& w : stable) tree.insert(w);
+
+    vector<vector<char>> present(writers); // writer t owns churn[i] for i % writers == t
+    atomic<int> writersLeft{writers};
+    atomic<size_t> readerErrors{0};
+    atomic<size_t> lookups{0};
+
+    auto start = Clock::now();
+    vector<thread> threads;
+    for(int t = 0; t < writers; t++){
+        threads.emplace_back([&, t]{
+            mt19937 rng(100 + t);
+            vector<char>& mine = present[t];
+            mine.assign(churn.size(), 0);
+            for(size_t op = 0; op < opsPerWriter; op++){
+                size_t i = (rng() % (churn.size() / writers)) * writers + t;
+                if(i >= churn.size()) continue;
+                if(rng() % 2 == 0){
+                    tree.insert(churn[i]);
+                    mine[i] = 1;
+                }
+                else{
+                    bool removed = tree.remove(churn[i]);
+                    if(removed != (mine[i] == 1)) readerErrors++; // only this thread touches churn[i]
+                    mine[i] = 0;
+                }
+            }
+            writersLeft--;
+        });
+    }
+    for(int t = 0; t < readers; t++){
+        threads.emplace_back([&, t]{
+            mt19937 rng(200 + t);
+            size_t n = 0;
+            while(writersLeft.load() > 0){
+                const string& s = stable[rng() % stable.size()];
+                const string& a = absent[rng() % absent.size()];
+                if(!tree.search(s) || !tree.startsWith(s)) readerErrors++;
+                if(tree.search(a)) readerErrors++;
+                tree.search(churn[rng() % churn.size()]); // result depends on timing, just walk it
+                n += 4;
+            }
+            lookups += n;
+        });
+    }
+    for(auto& th : threads) th.join();
+    double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+    size_t finalErrors = 0;
+    for(size_t i = 0; i < churn.size(); i++){
+        bool expected = present[i % writers][i] == 1;
+        if(tree.search(churn[i]) != expected) finalErrors++;
+    }
+    for(const auto& w : stable) if(!tree.search(w)) finalErrors++;
+    for(const auto& w : absent) if(tree.search(w)) finalErrors++;
+
+    // with the churn words gone, only prefixes of stable words may be left in the tree
+    for(size_t i = 0; i < churn.size(); i++) if(present[i % writers][i]) tree.remove(churn[i]);
+    unordered_set<string> stablePrefixes;
+    for(const auto& w : stable){
+        for(size_t len = 1; len <= w.size(); len++) stablePrefixes.insert(w.substr(0, len));
+    }
+    for(const auto& w : churn){
+        if(tree.startsWith(w) != (stablePrefixes.count(w) > 0)) finalErrors++;
+    }
+
+    cout << writers << " writers x " << opsPerWriter << " ops, " << readers << " readers ("
+         << lookups.load() << " lookups) in " << ms << " ms\n";
+    cout << "\terrors during run: " << readerErrors.load() << ", wrong at the end: " << finalErrors << "\n";
+    return readerErrors.load() == 0 && finalErrors == 0;
+}
+
+// ----------------------------
+// reclamation stress: every round fills the tree, then several removers prune
+// it at the same time (so several threads run EpochManager::collect() at
+// once) while readers keep walking the branches being freed. A node freed
+// too early shows up as a use after free under -fsanitize=address.
+// ----------------------------
+bool stressReclaim(const vector<string>& words, int removers, int readers, int rounds){
+    ConcurrentPrefixTree tree;
+    size_t errors = 0;
+
+    auto start = Clock::now();
+    for(int round = 0; round < rounds; round++){
+        for(const auto& w : words) tree.insert(w);
+
+        atomic<int> removersLeft{removers};
+        atomic<size_t> notRemoved{0};
+        vector<thread> threads;
+        for(int t = 0; t < removers; t++){
+            threads.emplace_back([&, t]{
+                for(size_t i = t; i < words.size(); i += removers){
+                    if(!tree.remove(words[i])) notRemoved++;
+                }
+                removersLeft--;
+            });
+        }
+        for(int t = 0; t < readers; t++){
+            threads.emplace_back([&, t]{
+                mt19937 rng(300 + t);
+                while(removersLeft.load() > 0){
+                    const string& w = words[rng() % words.size()];
+                    tree.search(w);
+                    tree.startsWith(w.substr(0, w.size() / 2 + 1));
+                }
+            });
+        }
+        for(auto& th : threads) th.join();
+
+        errors += notRemoved.load();
+        for(const auto& w : words) if(tree.startsWith(w.substr(0, 1))) errors++;
+    }
+    double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+    cout << rounds << " rounds of " << removers << " removers + " << readers << " readers over "
+         << words.size() << " words in " << ms << " ms\n";
+    cout << "\twrong: " << errors << "\n";
+    return errors == 0;
+}
+
+int main(int argc, char* argv[]){
+    size_t numWords = argc > 1 ? stoull(argv[1]) : 1000000;
+    size_t numQueries = argc > 2 ? stoull(argv[2]) : 200;
+    size_t bruteQueries = min<size_t>(numQueries, 10); // brute force is way too slow for all of them
+
+    mt19937 rng(42);
+    cout << "Generating " << numWords << " words...\n";
+    vector<string> words = makeDictionary(numWords, rng);
+
+    auto start = Clock::now();
+    PrefixTree tree;
+    for(const auto& w : words) tree.insert(w);
+    double buildMs = chrono::duration<double, milli>(Clock::now() - start).count();
+    cout << "Built tree in " << buildMs << " ms\n\n";
+
+    vector<string> queries;
+    for(size_t i = 0; i < numQueries; i++) queries.push_back(makeQuery(words, rng));
+
+    for(int k = 1; k <= 2; k++){
+        size_t matches = 0;
+        start = Clock::now();
+        for(const auto& q : queries) matches += tree.fuzzy_search(q, k).size();
+        double trieUs = chrono::duration<double, micro>(Clock::now() - start).count() / numQueries;
+
+        size_t bruteMatches = 0, trieMatches = 0;
+        start = Clock::now();
+        for(size_t i = 0; i < bruteQueries; i++) bruteMatches += bruteForce(words, queries[i], k);
+        double bruteUs = chrono::duration<double, micro>(Clock::now() - start).count() / bruteQueries;
+        for(size_t i = 0; i < bruteQueries; i++) trieMatches += tree.fuzzy_search(queries[i], k).size();
+
+        cout << "k=" << k << "\n";
+        cout << "\tfuzzy_search: " << trieUs << " us/query (" << (double)matches / numQueries << " matches avg)\n";
+        cout << "\tbrute force:  " << bruteUs << " us/query\n";
+        cout << "\tspeedup:      " << bruteUs / trieUs << "x\n";
+        if(bruteMatches != trieMatches){
+            cout << "\tMISMATCH: brute force found " << bruteMatches << ", fuzzy_search found " << trieMatches << "\n";
+            return 1;
+        }
+    }
+
+    int threads = argc > 3 ? stoi(argv[3]) : 3;
+    cout << "\nConcurrentPrefixTree stress\n";
+    vector<string> stressWords(words.begin(), words.begin() + min<size_t>(words.size(), 20000));
+    if(!stressConcurrent(stressWords, threads, threads, 200000) || !stressReclaim(stressWords, threads, threads, 20)){
+        cout << "\tFAILED\n";
+        return 1;
+    }
+}
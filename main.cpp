@@ -25,78 +25,820 @@ App (Main/Kindle device) (class)
 */
 
 #include <unordered_map>
+#include <map>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <cctype>
+#include <cstdio>
+#include <sys/mman.h>  // mmap for book files
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
 
+/*
+MappedFile: a book file mapped read only into memory.
+    - nothing is read up front, the OS pages the text in from disk the
+      first time a page of it is touched
+    - move only, unmaps in the destructor
+*/
+class MappedFile{
+private:
+    const char* data;
+    size_t length;
+
+public:
+    MappedFile(const string& path){
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) throw runtime_error("Can't open book file " + path);
+
+        struct stat info;
+        if(fstat(fd, &info) != 0){
+            close(fd);
+            throw runtime_error("Can't stat book file " + path);
+        }
+        length = info.st_size;
+        data = nullptr;
+
+        if(length > 0){ // mmap refuses 0 bytes
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p == MAP_FAILED){
+                close(fd);
+                throw runtime_error("Can't map book file " + path);
+            }
+            data = static_cast<const char*>(p);
+        }
+        close(fd); // the mapping stays valid without the fd
+    }
+
+    ~MappedFile(){
+        if(data != nullptr) munmap(const_cast<char*>(data), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& o) noexcept : data(o.data), length(o.length){
+        o.data = nullptr;
+        o.length = 0;
+    }
+
+    string_view view() const { return string_view(data, length); }
+};
+
+
+/*
+PageGeometry: what fits on one screen
+    - characters per line
+    - lines per page
+*/
+struct PageGeometry{
+    int columns = 60;
+    int lines = 20;
+
+    bool operator==(const PageGeometry& o) const {
+        return columns == o.columns && lines == o.lines;
+    }
+};
+
+
+/*
+PageIndex: byte offset where each page of a text starts, for one geometry.
+    - built lazily: asking for page n only lays out the text up to page n,
+      and later calls continue from where the last one stopped
+    - pages are string_views into the text, nothing is copied
+*/
+class PageIndex{
+private:
+    PageGeometry geometry;
+    vector<size_t> starts; // starts[i] = first byte of page i
+    bool complete;         // laid out to the end of the text
+
+    // lay out one page starting at starts.back(), remember where the next one starts
+    void layoutNextPage(string_view text){
+        size_t pos = starts.back();
+        for(int line = 0; line < geometry.lines && pos < text.size(); line++){
+            size_t lineEnd = min(text.size(), pos + geometry.columns);
+
+            size_t newline = text.substr(pos, lineEnd - pos).find('\n');
+            if(newline != string_view::npos){
+                pos += newline + 1; // hard line break
+                continue;
+            }
+            if(lineEnd == text.size()){
+                pos = lineEnd;
+                break;
+            }
+
+            // wrap at the last space that fits (a space right after the line counts),
+            // or cut the word if there is none. Only this line is searched.
+            size_t space = text.substr(pos, lineEnd - pos + 1).rfind(' ');
+            pos = (space != string_view::npos && space > 0) ? pos + space + 1 : lineEnd;
+        }
+
+        if(pos >= text.size()) complete = true;
+        else starts.push_back(pos);
+    }
+
+public:
+    PageIndex(PageGeometry g){
+        geometry = g;
+        starts.push_back(0);
+        complete = false;
+    }
+
+    const PageGeometry& getGeometry() const { return geometry; }
+
+    // page n (0 based), empty view past the end
+    string_view getPage(string_view text, int n){
+        while(!complete && (int)starts.size() <= n + 1) layoutNextPage(text);
+        if(n < 0 || n >= (int)starts.size()) return string_view();
+
+        size_t end = (n + 1 < (int)starts.size()) ? starts[n + 1] : text.size();
+        return text.substr(starts[n], end - starts[n]);
+    }
+
+    int getPageCount(string_view text){
+        while(!complete) layoutNextPage(text);
+        return starts.size();
+    }
+
+    // page the byte at offset is on, only lays out as far as that
+    int pageOf(string_view text, size_t offset){
+        while(!complete && starts.back() <= offset) layoutNextPage(text);
+        return upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+    }
+};
+
+
+/*
+BookText: the text of a book, either a string held in memory or a mapped
+file, plus its page indexes (one per geometry it was shown with).
+Shared between copies of a Book so the text is never copied.
+*/
+class BookText{
+private:
+    string content;                // in memory books
+    unique_ptr<MappedFile> file;   // books from disk
+    vector<PageIndex> pageIndexes;
+
+public:
+    BookText(string content_) : content(std::move(content_)) {}
+    BookText(MappedFile file_) : file(make_unique<MappedFile>(std::move(file_))) {}
+
+    string_view view() const {
+        return file ? file->view() : string_view(content);
+    }
+
+    PageIndex& pagesFor(const PageGeometry& g){
+        for(auto& index : pageIndexes){
+            if(index.getGeometry() == g) return index;
+        }
+        pageIndexes.emplace_back(g);
+        return pageIndexes.back();
+    }
+};
+
+
+/*
+BookStore: maps book files from disk. A file that's already open is handed
+out again instead of being mapped twice.
+*/
+class BookStore{
+private:
+    unordered_map<string, weak_ptr<BookText>> openFiles;
+
+public:
+    shared_ptr<BookText> load(const string& path){
+        auto it = openFiles.find(path);
+        if(it != openFiles.end()){
+            if(auto text = it->second.lock()) return text;
+        }
+        auto text = make_shared<BookText>(MappedFile(path));
+        openFiles[path] = text;
+        return text;
+    }
+};
+
+
+/*
+xxHash64 (XXH64) of a byte range: fast, well spread 64 bit hash used for
+book IDs, so two different books practically never share an ID.
+*/
+class BookHash{
+private:
+    static constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t P3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t rotl(uint64_t x, int r){ return (x << r) | (x >> (64 - r)); }
+    static uint64_t read64(const char* p){ uint64_t v; memcpy(&v, p, 8); return v; }
+    static uint32_t read32(const char* p){ uint32_t v; memcpy(&v, p, 4); return v; }
+
+    static uint64_t round(uint64_t acc, uint64_t input){
+        acc += input * P2;
+        acc = rotl(acc, 31);
+        return acc * P1;
+    }
+    static uint64_t mergeRound(uint64_t acc, uint64_t v){
+        acc ^= round(0, v);
+        return acc * P1 + P4;
+    }
+
+public:
+    static uint64_t hash(string_view data, uint64_t seed = 0){
+        const char* p = data.data();
+        const char* end = p + data.size();
+        uint64_t h;
+
+        if(data.size() >= 32){
+            uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+            for(; p + 32 <= end; p += 32){
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+            }
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        }
+        else h = seed + P5;
+
+        h += data.size();
+        for(; p + 8 <= end; p += 8) h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+        if(p + 4 <= end){
+            h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+            p += 4;
+        }
+        for(; p < end; p++) h = rotl(h ^ (static_cast<unsigned char>(*p) * P5), 11) * P1;
+
+        // avalanche
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+};
+
+
 /*
 Book (BOOK CLASS) is a sequence of charaters (class)
     - title
-    - last (current) page user is reading
-    - bookContents
+    - author
+    - bookID: content address, xxHash64 of title + author + text
+    - bookContents (shared BookText)
+Only BookCatalog makes Books, and there is one per distinct book no matter
+how many users have it. Reading progress lives in the user's ReadingState.
 */
 class Book{
 private:
     string title;
     string author;
-    int bookID;
-    string content;
-    int currentPage;
+    uint64_t bookID;
+    shared_ptr<BookText> content;
+
+public:
+    Book(string title_, string author_, shared_ptr<BookText> content_, uint64_t id_){
+        title = std::move(title_);
+        author = std::move(author_);
+        content = std::move(content_);
+        bookID = id_;
+    }
+
+    static uint64_t calcBookID(string_view t, string_view a, string_view text){
+        uint64_t h = BookHash::hash(t);
+        h = BookHash::hash(a, h);
+        return BookHash::hash(text, h);
+    }
+
+    const string& getTitle() const {return title;}
+    const string& getAuthor() const {return author;}
+    string_view getContent() const {return content->view();}
+    uint64_t getBookID() const {return bookID;}
+
+    string_view getPage(int page, const PageGeometry& g){
+        return content->pagesFor(g).getPage(content->view(), page);
+    }
+    int getPageCount(const PageGeometry& g){
+        return content->pagesFor(g).getPageCount(content->view());
+    }
+    int getPageOf(size_t offset, const PageGeometry& g){
+        return content->pagesFor(g).pageOf(content->view(), offset);
+    }
+};
+
+
+/*
+BookCatalog: every book on the device, stored once.
+    - keyed by content address, adding the same book again hands back the
+      copy already in memory
+    - users keep the books alive (shared_ptr); once nobody has a book any
+      more it's freed and the catalog only holds an expired weak_ptr
+*/
+class BookCatalog{
+private:
+    unordered_map<uint64_t, weak_ptr<Book>> books;
+    BookStore store;
+    size_t sweepAt = 64; // drop expired entries when the map grows past this
+
+    shared_ptr<Book> intern(string title, string author, shared_ptr<BookText> text){
+        uint64_t id = Book::calcBookID(title, author, text->view());
+
+        auto it = books.find(id);
+        if(it != books.end()){
+            if(auto existing = it->second.lock()){
+                if(existing->getTitle() != title || existing->getAuthor() != author || existing->getContent() != text->view()){
+                    throw runtime_error("Book ID collision for " + title);
+                }
+                return existing;
+            }
+        }
+
+        if(books.size() >= sweepAt){
+            for(auto b = books.begin(); b != books.end();){
+                if(b->second.expired()) b = books.erase(b);
+                else ++b;
+            }
+            sweepAt = max<size_t>(64, books.size() * 2);
+        }
 
-    int calcBookID(string t, string a){
-        return t.at(0) * a.at(1);
+        auto book = make_shared<Book>(std::move(title), std::move(author), std::move(text), id);
+        books[id] = book;
+        return book;
     }
+
 public:
-    Book(string title_, string author_, string content_, int page_){
-        title = title_;
-        author = author_;
-        bookID = calcBookID(title_, author_);
-        content = content_;
-        currentPage = page_;
-    }
-
-    string getTitle(){return title;}
-    string getAuthor(){return author;}
-    string getContent(){return content;}
-    int getBookID(){return bookID;}
+    shared_ptr<Book> add(string title, string author, string content){
+        return intern(std::move(title), std::move(author), make_shared<BookText>(std::move(content)));
+    }
+
+    // the whole file is read once to hash it, after that pages load on demand
+    shared_ptr<Book> addFile(string title, string author, const string& path){
+        return intern(std::move(title), std::move(author), store.load(path));
+    }
+
+    // nullptr if no user has that book any more
+    shared_ptr<Book> find(uint64_t id) const {
+        auto it = books.find(id);
+        return it == books.end() ? nullptr : it->second.lock();
+    }
+};
+
+
+/*
+SearchIndex: full text search over every indexed book
+    - inverted index: term => postings, kept in a sorted map so prefix
+      queries are a range scan
+    - a posting list is a byte string of varints, per book:
+          doc delta, number of positions, position deltas (word numbers)
+    - books get small sequential doc numbers as they're added, so new books
+      only ever append to the end of a posting list
+    - each book remembers the byte offset of every 64th word. A hit's word
+      number becomes a byte offset by scanning at most 63 words from there,
+      and the byte offset becomes a page of whatever screen the reader has
+    - save()/load() write it all to one file so it isn't rebuilt at startup
+*/
+struct SearchHit{
+    uint64_t bookID;
+    vector<int> pages; // 0 based, sorted
+};
+
+class SearchIndex{
+private:
+    struct PostingList{
+        vector<uint8_t> bytes;
+        uint32_t lastDoc = 0;
+        uint32_t docCount = 0;
+    };
+
+    static constexpr uint32_t CHECKPOINT_EVERY = 64;
+
+    struct IndexedBook{
+        uint64_t bookID;
+        vector<uint64_t> checkpoints; // checkpoints[i] = byte offset of word i * CHECKPOINT_EVERY
+    };
+
+    vector<IndexedBook> docs;              // doc number => book
+    unordered_map<uint64_t, uint32_t> docOf; // book ID => doc number
+    map<string, PostingList> terms;
+
+    static void putVarint(vector<uint8_t>& out, uint64_t v){
+        while(v >= 0x80){
+            out.push_back(static_cast<uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    static uint64_t getVarint(const uint8_t*& p, const uint8_t* end){
+        uint64_t v = 0;
+        int shift = 0;
+        while(p < end){
+            uint8_t b = *p++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if(!(b & 0x80)) return v;
+            shift += 7;
+            if(shift >= 64) throw runtime_error("SearchIndex: varint too long");
+        }
+        throw runtime_error("SearchIndex: truncated varint");
+    }
+
+    static bool isWordChar(char c){
+        return isalnum(static_cast<unsigned char>(c));
+    }
+
+    // lowercase runs of letters/digits, calls f(word, byte offset) for each
+    template <typename F>
+    static void tokenize(string_view text, F f){
+        string word;
+        size_t start = 0;
+        for(size_t i = 0; i < text.size(); i++){
+            if(isWordChar(text[i])){
+                if(word.empty()) start = i;
+                word.push_back(tolower(static_cast<unsigned char>(text[i])));
+            }
+            else if(!word.empty()){
+                f(word, start);
+                word.clear();
+            }
+        }
+        if(!word.empty()) f(word, start);
+    }
+
+    // byte offset of the word skip words after the one starting at pos
+    static size_t skipWords(string_view text, size_t pos, uint32_t skip){
+        for(; skip > 0; skip--){
+            while(pos < text.size() && isWordChar(text[pos])) pos++;
+            while(pos < text.size() && !isWordChar(text[pos])) pos++;
+        }
+        return pos;
+    }
+
+    // doc number => positions of one query term (a prefix term merges every
+    // term it matches). Books the library doesn't have are skipped.
+    template <typename Library>
+    unordered_map<uint32_t, vector<uint32_t>> lookup(const string& term, bool prefix, Library& library) const {
+        unordered_map<uint32_t, vector<uint32_t>> result;
+
+        auto decode = [&](const PostingList& list){
+            const uint8_t* p = list.bytes.data();
+            const uint8_t* end = p + list.bytes.size();
+            uint32_t doc = 0;
+            while(p < end){
+                doc += getVarint(p, end);
+                uint64_t n = getVarint(p, end);
+                bool wanted = library(docs[doc].bookID) != nullptr;
+                vector<uint32_t>* positions = wanted ? &result[doc] : nullptr;
+
+                uint32_t pos = 0;
+                for(uint64_t i = 0; i < n; i++){
+                    pos += getVarint(p, end);
+                    if(positions) positions->push_back(pos);
+                }
+            }
+        };
+
+        if(!prefix){
+            auto it = terms.find(term);
+            if(it != terms.end()) decode(it->second);
+            return result;
+        }
+
+        for(auto it = terms.lower_bound(term); it != terms.end() && it->first.compare(0, term.size(), term) == 0; ++it){
+            decode(it->second);
+        }
+        // positions of different terms got appended one after another
+        for(auto& [doc, positions] : result) sort(positions.begin(), positions.end());
+        return result;
+    }
+
+    // every doc number in range and increasing, every word number covered by
+    // the book's checkpoints, and lastDoc/docCount agreeing with the bytes.
+    // Queries index docs[] with these, so load() checks them all.
+    bool validPostings(const PostingList& list) const {
+        const uint8_t* p = list.bytes.data();
+        const uint8_t* end = p + list.bytes.size();
+        uint64_t doc = 0;
+        uint32_t count = 0;
+        while(p < end){
+            uint64_t delta = getVarint(p, end);
+            if(count > 0 && delta == 0) return false;
+            doc += delta;
+            if(doc >= docs.size()) return false;
+
+            uint64_t limit = docs[doc].checkpoints.size() * (uint64_t)CHECKPOINT_EVERY;
+            uint64_t n = getVarint(p, end);
+            uint64_t pos = 0;
+            for(uint64_t i = 0; i < n; i++){
+                pos += getVarint(p, end);
+                if(pos >= limit) return false;
+            }
+            count++;
+        }
+        return count == list.docCount && (count == 0 || doc == list.lastDoc);
+    }
+
+public:
+    bool contains(uint64_t bookID) const {
+        return docOf.count(bookID) > 0;
+    }
+
+    // index a book. Does nothing if it's already in the index.
+    void addBook(Book& book){
+        if(contains(book.getBookID())) return;
+
+        uint32_t doc = docs.size();
+        IndexedBook entry{book.getBookID(), {}};
+
+        unordered_map<string, vector<uint32_t>> positions;
+        uint32_t wordNumber = 0;
+        tokenize(book.getContent(), [&](const string& word, size_t offset){
+            if(wordNumber % CHECKPOINT_EVERY == 0) entry.checkpoints.push_back(offset);
+            positions[word].push_back(wordNumber++);
+        });
+
+        // append this book to each term's postings
+        for(auto& [word, list] : positions){
+            PostingList& postings = terms[word];
+            putVarint(postings.bytes, doc - postings.lastDoc);
+            putVarint(postings.bytes, list.size());
+            uint32_t prev = 0;
+            for(uint32_t pos : list){
+                putVarint(postings.bytes, pos - prev);
+                prev = pos;
+            }
+            postings.lastDoc = doc;
+            postings.docCount++;
+        }
+
+        docs.push_back(std::move(entry));
+        docOf[book.getBookID()] = doc;
+    }
+
+    /*
+    query: words to find next to each other ("lazy fox"); a word ending in *
+    matches every word starting with it ("laz*"). library(bookID) returns the
+    Book to look in, or nullptr to skip it. Pages are numbered for screen.
+    */
+    template <typename Library>
+    vector<SearchHit> search(string_view query, const PageGeometry& screen, Library library) const {
+        vector<string> words;
+        vector<bool> prefixes;
+        string current;
+        for(char c : query){
+            unsigned char u = static_cast<unsigned char>(c);
+            if(isalnum(u)) current.push_back(tolower(u));
+            else if(c == '*' && !current.empty()){
+                words.push_back(current);
+                prefixes.push_back(true);
+                current.clear();
+            }
+            else if(!current.empty()){
+                words.push_back(current);
+                prefixes.push_back(false);
+                current.clear();
+            }
+        }
+        if(!current.empty()){
+            words.push_back(current);
+            prefixes.push_back(false);
+        }
+
+        vector<SearchHit> hits;
+        if(words.empty()) return hits;
+
+        vector<unordered_map<uint32_t, vector<uint32_t>>> postings;
+        for(size_t i = 0; i < words.size(); i++){
+            postings.push_back(lookup(words[i], prefixes[i], library));
+            if(postings.back().empty()) return hits; // a word that's nowhere
+        }
+
+        // phrase match: word i has to be at start + i in the same book
+        for(auto& [doc, starts] : postings[0]){
+            vector<uint32_t> matches;
+            for(uint32_t start : starts){
+                bool ok = true;
+                for(size_t i = 1; i < words.size() && ok; i++){
+                    auto it = postings[i].find(doc);
+                    ok = it != postings[i].end() && binary_search(it->second.begin(), it->second.end(), start + (uint32_t)i);
+                }
+                if(ok) matches.push_back(start);
+            }
+            if(matches.empty()) continue;
+
+            SearchHit hit{docs[doc].bookID, {}};
+            shared_ptr<Book> book = library(hit.bookID);
+            string_view text = book->getContent();
+            const vector<uint64_t>& checkpoints = docs[doc].checkpoints;
+
+            // matches are sorted: carry on from the last one unless a checkpoint is closer
+            uint32_t word = 0;
+            size_t offset = checkpoints.empty() ? 0 : checkpoints[0];
+            for(uint32_t m : matches){
+                uint32_t checkpoint = m / CHECKPOINT_EVERY;
+                if(checkpoint * CHECKPOINT_EVERY > word){
+                    word = checkpoint * CHECKPOINT_EVERY;
+                    offset = checkpoints[checkpoint];
+                }
+                offset = skipWords(text, offset, m - word);
+                word = m;
+
+                int page = book->getPageOf(offset, screen);
+                if(hit.pages.empty() || hit.pages.back() != page) hit.pages.push_back(page);
+            }
+            hits.push_back(std::move(hit));
+        }
+
+        // books with the most hits first
+        sort(hits.begin(), hits.end(), [](const SearchHit& a, const SearchHit& b){
+            return a.pages.size() != b.pages.size() ? a.pages.size() > b.pages.size() : a.bookID < b.bookID;
+        });
+        return hits;
+    }
+
+    // ----------------------------
+    // persistence: little endian binary, varints for all the counts
+    // ----------------------------
+    void save(const string& path) const {
+        vector<uint8_t> out;
+        const char magic[4] = {'K', 'I', 'D', 'X'};
+        out.insert(out.end(), magic, magic + 4);
+        putVarint(out, 2); // format version
+
+        putVarint(out, docs.size());
+        for(const auto& d : docs){
+            putVarint(out, d.bookID);
+            putVarint(out, d.checkpoints.size());
+            uint64_t prev = 0;
+            for(uint64_t c : d.checkpoints){
+                putVarint(out, c - prev);
+                prev = c;
+            }
+        }
+
+        putVarint(out, terms.size());
+        for(const auto& [word, list] : terms){
+            putVarint(out, word.size());
+            out.insert(out.end(), word.begin(), word.end());
+            putVarint(out, list.lastDoc);
+            putVarint(out, list.docCount);
+            putVarint(out, list.bytes.size());
+            out.insert(out.end(), list.bytes.begin(), list.bytes.end());
+        }
+
+        // write next to the old file and rename, so a crash never leaves half an index
+        string temp = path + ".tmp";
+        ofstream file(temp, ios::binary | ios::trunc);
+        if(!file.is_open()) throw runtime_error("Can't write search index " + temp);
+        file.write(reinterpret_cast<const char*>(out.data()), out.size());
+        file.close();
+        if(!file || rename(temp.c_str(), path.c_str()) != 0) throw runtime_error("Can't write search index " + path);
+    }
+
+    // false if there is no index file yet; throws if the file is damaged
+    bool load(const string& path){
+        ifstream file(path, ios::binary);
+        if(!file.is_open()) return false;
+        vector<uint8_t> in((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        const uint8_t* p = in.data();
+        const uint8_t* end = p + in.size();
+        if(in.size() < 4 || memcmp(p, "KIDX", 4) != 0) throw runtime_error("Not a search index: " + path);
+        p += 4;
+        if(getVarint(p, end) != 2) throw runtime_error("Unknown search index version: " + path);
+
+        SearchIndex loaded;
+        uint64_t docCount = getVarint(p, end);
+        for(uint64_t i = 0; i < docCount; i++){
+            IndexedBook d;
+            d.bookID = getVarint(p, end);
+            uint64_t checkpoints = getVarint(p, end);
+            uint64_t c = 0;
+            for(uint64_t j = 0; j < checkpoints; j++){
+                c += getVarint(p, end);
+                d.checkpoints.push_back(c);
+            }
+            loaded.docOf[d.bookID] = loaded.docs.size();
+            loaded.docs.push_back(std::move(d));
+        }
+
+        uint64_t termCount = getVarint(p, end);
+        for(uint64_t i = 0; i < termCount; i++){
+            uint64_t length = getVarint(p, end);
+            if((uint64_t)(end - p) < length) throw runtime_error("Truncated search index: " + path);
+            string word(reinterpret_cast<const char*>(p), length);
+            p += length;
+
+            PostingList list;
+            list.lastDoc = getVarint(p, end);
+            list.docCount = getVarint(p, end);
+            uint64_t bytes = getVarint(p, end);
+            if((uint64_t)(end - p) < bytes) throw runtime_error("Truncated search index: " + path);
+            list.bytes.assign(p, p + bytes);
+            p += bytes;
+            if(!loaded.validPostings(list)) throw runtime_error("Damaged posting list for \"" + word + "\" in " + path);
+            loaded.terms.emplace_hint(loaded.terms.end(), std::move(word), std::move(list));
+        }
+
+        *this = std::move(loaded);
+        return true;
+    }
+};
+
+
+/*
+ReadingState: one user's progress in one book
+    - the book itself is shared through the catalog
+*/
+struct ReadingState{
+    shared_ptr<Book> book;
+    int currentPage = 0;
+    vector<int> bookmarks;
+
+    ReadingState(shared_ptr<Book> book_) : book(std::move(book_)) {}
 };
 
 class User{
 private:
     string userName;
 
-    //atm, 1 user = 1 library. 
-    //move library to external class for many users => 1 book relationship 
-    unordered_map<int, Book> user_library; 
-    int active_book_id;
+    // 1 user = 1 library of reading states, the books are in the catalog
+    unordered_map<uint64_t, ReadingState> user_library;
+    uint64_t active_book_id;
 
 public:
     User(string name_){
-        userName = name_;
+        userName = std::move(name_);
     }
-    string getUserName(){
+    const string& getUserName() const {
         return userName;
     }
-    void addBook(Book b){
-        user_library.insert({b.getBookID(), b});
-        active_book_id = b.getBookID(); //change later
+    void addBook(shared_ptr<Book> b){
+        uint64_t id = b->getBookID();
+        user_library.try_emplace(id, std::move(b)); // keeps progress if already added
+        active_book_id = id; //change later
     }
 
     string getBookTitle(){
         if(user_library.size() < 1) return "No books in library!";
-        return user_library.at(active_book_id).getTitle();
+        return user_library.at(active_book_id).book->getTitle();
+    }
+
+    string_view getBookContent(){
+        if(user_library.size() < 1) return "No books in library!";
+        return user_library.at(active_book_id).book->getContent();
     }
 
-    string getBookContent(){
+    // current page of the active book, moved by delta pages first
+    string_view turnPage(int delta, const PageGeometry& g){
         if(user_library.size() < 1) return "No books in library!";
-        return user_library.at(active_book_id).getContent();
+        ReadingState& state = user_library.at(active_book_id);
+        Book& book = *state.book;
+
+        int page = state.currentPage + delta;
+        if(page < 0) page = 0;
+        if(delta > 0 && book.getPage(page, g).empty()) page = book.getPageCount(g) - 1; // stop at the last page
+        state.currentPage = page;
+        return book.getPage(page, g);
+    }
+
+    void addBookmark(){
+        if(user_library.size() < 1) return;
+        ReadingState& state = user_library.at(active_book_id);
+        state.bookmarks.push_back(state.currentPage);
+    }
+    vector<int> getBookmarks(){
+        if(user_library.size() < 1) return {};
+        return user_library.at(active_book_id).bookmarks;
+    }
+
+    bool hasBook(uint64_t id) const {
+        return user_library.count(id) > 0;
+    }
+    string getTitleOf(uint64_t id) const {
+        auto it = user_library.find(id);
+        return it == user_library.end() ? "" : it->second.book->getTitle();
     }
 
     void printLibrary(){
-        for(auto& [key, book] : user_library){
-            cout << book.getTitle() << " by " << book.getAuthor() << endl;
+        for(auto& [key, state] : user_library){
+            cout << state.book->getTitle() << " by " << state.book->getAuthor()
+                 << " (page " << state.currentPage + 1 << ")" << endl;
         }
     }
 };
@@ -105,10 +847,18 @@ class Kindle{
 private:
     vector<User> users;
     int currentUserIndex;
+    BookCatalog catalog;
+    SearchIndex index;
+    PageGeometry screen;
+
+    void addToCurrentUser(shared_ptr<Book> book){
+        index.addBook(*book); // no-op if it was indexed before (or loaded from disk)
+        users.at(currentUserIndex).addBook(std::move(book));
+    }
 public:
     Kindle(){};
     void add_user(User u){
-        users.push_back(u);
+        users.push_back(std::move(u));
         if(users.size() == 1) currentUserIndex = 0;
     }
 
@@ -124,22 +874,54 @@ public:
         return users.at(currentUserIndex).getUserName();
     }
 
-    void addBook(Book b){
-        users.at(currentUserIndex).addBook(b);
+    void addBook(string title, string author, string content){
+        addToCurrentUser(catalog.add(std::move(title), std::move(author), std::move(content)));
+    }
+    // book text stays on disk, pages are read in as they're shown
+    void addBookFile(string title, string author, const string& path){
+        addToCurrentUser(catalog.addFile(std::move(title), std::move(author), path));
     }
 
-    // get content -- display methods -- formatting/limiting content for page size/# lines missing
+    // phrase/prefix search over the current user's books, see SearchIndex::search
+    vector<SearchHit> search(string_view query){
+        const User& user = users.at(currentUserIndex);
+        return index.search(query, screen, [&](uint64_t id){
+            return user.hasBook(id) ? catalog.find(id) : nullptr;
+        });
+    }
+    void printSearch(string_view query){
+        const User& user = users.at(currentUserIndex);
+        cout << "Search \"" << query << "\":" << endl;
+        for(const auto& hit : search(query)){
+            cout << "\t" << user.getTitleOf(hit.bookID) << ": page";
+            for(int page : hit.pages) cout << " " << page + 1;
+            cout << endl;
+        }
+    }
+
+    // keep the index between runs so it isn't rebuilt at startup
+    bool loadIndex(const string& path){return index.load(path);}
+    void saveIndex(const string& path){index.save(path);}
+
+    void setScreen(PageGeometry g){screen = g;}
+
+    // get content -- display methods
     string getContentTitle(){
-        string content = users.at(currentUserIndex).getBookTitle();
-        return content;
+        return users.at(currentUserIndex).getBookTitle();
     }
-    string getContent(){
-        string content = users.at(currentUserIndex).getBookContent();
-        return content;
+    string_view getContent(){
+        return users.at(currentUserIndex).getBookContent();
     }
+
+    // page the current user is on in the active book
+    string_view getPage(){return users.at(currentUserIndex).turnPage(0, screen);}
+    string_view nextPage(){return users.at(currentUserIndex).turnPage(1, screen);}
+    string_view prevPage(){return users.at(currentUserIndex).turnPage(-1, screen);}
+    void addBookmark(){users.at(currentUserIndex).addBookmark();}
+    void printLibrary(){users.at(currentUserIndex).printLibrary();}
 };
 
-int main(){
+int main(int argc, char* argv[]){
 
     Kindle k;
 
@@ -150,7 +932,7 @@ int main(){
     //swap to mike
     k.setCurrentUser(2);
     cout << k.getCurrentUser() << endl;
-    k.addBook(Book("Title", "Mr. Author", "The lazy fox...", 1));
+    k.addBook("Title", "Mr. Author", "The lazy fox...");
     cout << "Current content title: " << k.getContentTitle() << endl;
     cout << "Current book's content: " << k.getContent() << endl;
 
@@ -158,4 +940,19 @@ int main(){
     k.setCurrentUser(1);
     cout << "Current content title: " << k.getContent() << endl;
 
-}
\ No newline at end of file
+    // same book for adrian: shares mike's copy, but has its own page
+    k.addBook("Title", "Mr. Author", "The lazy fox...");
+    k.addBook("Fables", "Aesop", "The quick brown fox jumps over the lazy dog. The lazy dog sleeps.");
+    k.printLibrary();
+    k.printSearch("lazy dog");
+    k.printSearch("laz*");
+
+    // ./Kindle book.txt => flip through a book from disk
+    if(argc > 1){
+        k.addBookFile("From disk", "Unknown", argv[1]);
+        k.setScreen({60, 10});
+        cout << "Page 1:\n" << k.getPage() << endl;
+        cout << "Page 2:\n" << k.nextPage() << endl;
+        k.printSearch("the");
+    }
+}